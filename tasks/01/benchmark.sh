@@ -1,6 +1,6 @@
 #!/bin/sh
 
-for testType in a A b B c C ; do
+for testType in a A b B c C d D e E ; do
     times=()
     for i in $(seq 1 10) ; do
         times+=($(./a.out $testType))
@@ -0,0 +1,138 @@
+# include "concvector.h"
+
+# include <iostream>
+# include <cstdlib>
+# include <cstdio>
+# include <cctype>
+# include <vector>
+# include <thread>
+# include <mutex>
+# include <chrono>
+
+//
+// Many producers appending to one container: lock-free myconcurrent_vector
+// versus std::vector guarded by a mutex. Each of nThreads threads appends
+// nTotal/nThreads integers (one by one, or with grow_by() in chunks). Values
+// are distinct (chunk copies of the chunk's first index in the chunked
+// mode), so the integrity check finds every appended value exactly once.
+//
+// Build with, e.g.:
+//  $ g++ -std=c++11 -O2 -pthread concurrent-bench.cpp -o concurrent-bench
+
+typedef std::chrono::high_resolution_clock Clock;
+
+struct MutexVector {
+    std::mutex m;
+    std::vector<int> v;
+
+    void push_back( int x ) {
+        std::lock_guard<std::mutex> g(m);
+        v.push_back(x);
+    }
+    size_t grow_by( size_t n, int x ) {
+        std::lock_guard<std::mutex> g(m);
+        size_t i = v.size();
+        v.insert( v.end(), n, x );
+        return i;
+    }
+    size_t size() const { return v.size(); }
+    int operator[]( size_t i ) const { return v[i]; }
+};
+
+template<typename ContainerT> double
+run( ContainerT & c, size_t nThreads, size_t nTotal, size_t chunk ) {
+    std::vector<std::thread> ts;
+    const size_t perThread = nTotal/nThreads;
+    Clock::time_point s = Clock::now();
+    for( size_t t = 0; t < nThreads; ++t ) {
+        ts.push_back( std::thread( [&c, t, perThread, chunk](){
+                const size_t first = t*perThread;
+                if( 1 == chunk ) {
+                    for( size_t i = 0; i < perThread; ++i ) {
+                        c.push_back( int(first + i) );
+                    }
+                } else {
+                    for( size_t i = 0; i < perThread; i += chunk ) {
+                        c.grow_by( chunk, int(first + i) );
+                    }
+                }
+            } ) );
+    }
+    for( auto & th : ts ) {
+        th.join();
+    }
+    Clock::time_point e = Clock::now();
+    return std::chrono::duration<double, std::milli>(e - s).count();
+}
+
+/// Every value appended by run() must be present exactly once (chunk times
+/// for the first index of chunk).
+template<typename ContainerT> bool
+check( const ContainerT & c, size_t nTotal, size_t chunk ) {
+    std::vector<size_t> counts( nTotal, 0 );
+    if( c.size() != nTotal ) {
+        std::cerr << "Integrity check failure: " << c.size()
+                  << " items instead of " << nTotal << std::endl;
+        return false;
+    }
+    for( size_t i = 0; i < nTotal; ++i ) {
+        const size_t v = (size_t) c[i];
+        if( v >= nTotal ) {
+            std::cerr << "Integrity check failure: item #" << i
+                      << " holds unexpected value " << v << std::endl;
+            return false;
+        }
+        ++counts[v];
+    }
+    for( size_t v = 0; v < nTotal; ++v ) {
+        if( counts[v] != (v % chunk ? 0 : chunk) ) {
+            std::cerr << "Integrity check failure: value " << v
+                      << " appended " << counts[v] << " times" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Parses positive count argument, returns 0 if it is zero or not a number.
+static size_t
+count_arg( const char * arg ) {
+    if( !isdigit( (unsigned char) *arg ) ) {
+        return 0;
+    }
+    char * end;
+    const size_t n = strtoul( arg, &end, 0 );
+    return *end ? 0 : n;
+}
+
+int
+main( int argc, char * const argv[] ) {
+    const size_t nTotal = argc > 1 ? count_arg( argv[1] ) : (1 << 24),
+                 chunk = argc > 2 ? count_arg( argv[2] ) : 1;
+    if( argc > 3 || !nTotal || !chunk ) {
+        std::cerr << "Usage:" << std::endl
+                  << "    $ " << argv[0] << " [nTotal [chunk]]" << std::endl
+                  ;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "# " << nTotal << " items, chunk=" << chunk
+              << ", hw threads=" << std::thread::hardware_concurrency() << std::endl
+              << "# threads  concurrent,ms  mutex+std::vector,ms" << std::endl;
+    for( size_t nThreads = 1; nThreads <= 64; nThreads *= 2 ) {
+        const size_t perThread = ((nTotal/nThreads)/chunk)*chunk;
+        double tc, tm;
+        {
+            myconcurrent_vector<int> c;
+            tc = run( c, nThreads, perThread*nThreads, chunk );
+            if( !check( c, perThread*nThreads, chunk ) ) return EXIT_FAILURE;
+        }
+        {
+            MutexVector m;
+            tm = run( m, nThreads, perThread*nThreads, chunk );
+            if( !check( m, perThread*nThreads, chunk ) ) return EXIT_FAILURE;
+        }
+        printf( "%9zu  %13.2f  %20.2f\n", nThreads, tc, tm );
+    }
+    return EXIT_SUCCESS;
+}
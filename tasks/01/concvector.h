@@ -0,0 +1,169 @@
+# ifndef H_RDUS_MYCONCVEC_H
+# define H_RDUS_MYCONCVEC_H
+
+# include "segvector.h"
+
+# include <atomic>
+# include <cstdint>
+# include <thread>
+
+//
+// Append-only vector for concurrent producers. Storage is segmented in the
+// same way as mysegvector (see SegmentedIndexing), so growth never moves
+// elements and references returned by push_back()/grow_by() stay valid for
+// the container's lifetime.
+//
+// Slot is reserved with a single atomic fetch-add, so push_back() and
+// grow_by() are lock-free while they append to allocated blocks. The first
+// thread that needs a missing block claims it with compare-and-swap of a
+// "being allocated" marker and publishes the block once allocated; other
+// threads needing the same block wait (yielding) for it instead of
+// allocating and freeing a block of their own -- late blocks are a half of
+// the capacity, so such races would cost that much transient memory.
+//
+// size() counts reserved slots. Element is guaranteed to be constructed
+// only once the thread that appended it synchronized with reader (e.g. was
+// joined), so concurrent readers must rely on own synchronization (or on the
+// returned reference/index).
+//
+// Destructor and clear() are not thread-safe.
+
+template<typename T, unsigned BaseShiftT=4>
+class myconcurrent_vector {
+public:
+    typedef myconcurrent_vector<T, BaseShiftT> Self;
+    typedef SegmentedIndexing<BaseShiftT> Indexing;
+    static const unsigned nBlocksMax = Indexing::nBlocksMax;
+private:
+    std::atomic<T*> _blocks[nBlocksMax];
+    std::atomic<size_t> _size;
+protected:
+    /// Marks the block being allocated by one of the threads.
+    static T * _allocating() { return reinterpret_cast<T*>( uintptr_t(1) ); }
+    /// Returns pointer to k-th block, allocating it if need.
+    T * _block( unsigned k );
+    T * _slot( size_t i ) {
+        unsigned k;
+        size_t o;
+        Indexing::decompose( i, k, o );
+        return _block(k) + o;
+    }
+    T * _ptr( size_t i ) const {
+        unsigned k;
+        size_t o;
+        Indexing::decompose( i, k, o );
+        return _blocks[k].load( std::memory_order_acquire ) + o;
+    }
+public:
+    myconcurrent_vector() : _size(0) {
+        for( unsigned k = 0; k < nBlocksMax; ++k ) {
+            _blocks[k].store( nullptr_C11, std::memory_order_relaxed );
+        }
+    }
+    ~myconcurrent_vector() { clear(); }
+
+    myconcurrent_vector( const Self & ) = delete;
+    Self & operator=( const Self & ) = delete;
+
+    size_t size() const { return _size.load( std::memory_order_acquire ); }
+
+    /// Thread-safe. Returns reference to the appended element.
+    T & push_back( const T & value ) {
+        const size_t i = _size.fetch_add( 1, std::memory_order_relaxed );
+        return *new (_slot(i)) T(value);
+    }
+    /// Thread-safe. Appends n copies of value to contiguous index range
+    /// and returns its first index.
+    size_t grow_by( size_t n, const T & value=T() );
+
+    /// Allocates blocks to hold at least n elements. Thread-safe.
+    void reserve( size_t n );
+
+    T & operator[]( size_t index ) { return *_ptr(index); }
+    const T & operator[]( size_t index ) const { return *_ptr(index); }
+    const T & at( size_t index ) const {
+        if(!(size() > index)) {
+            throw std::out_of_range( "Concurrent vector index overflow." );
+        }
+        return *_ptr(index);
+    }
+    T & at( size_t index ) {
+        const Self * cSelf = this;
+        return const_cast<T&>( cSelf->at(index) ); }
+
+    /// Not thread-safe.
+    void clear();
+};  // myconcurrent_vector
+
+template<typename T, unsigned BaseShiftT> T *
+myconcurrent_vector<T, BaseShiftT>::_block( unsigned k ) {
+    if( k >= nBlocksMax ) {
+        throw std::bad_alloc();
+    }
+    T * b = _blocks[k].load( std::memory_order_acquire );
+    while( !b || _allocating() == b ) {
+        if( b ) {
+            // another thread allocates the block
+            std::this_thread::yield();
+            b = _blocks[k].load( std::memory_order_acquire );
+            continue;
+        }
+        if( !_blocks[k].compare_exchange_strong( b, _allocating(),
+                                                 std::memory_order_acquire ) ) {
+            continue;  // `b' is updated with the marker or the block
+        }
+        try {
+            b = static_cast<T*>(
+                    ::operator new( sizeof(T)*Indexing::block_size(k) ) );
+        } catch( ... ) {
+            // let waiting threads retry
+            _blocks[k].store( nullptr_C11, std::memory_order_release );
+            throw;
+        }
+        _blocks[k].store( b, std::memory_order_release );
+    }
+    return b;
+}
+
+template<typename T, unsigned BaseShiftT> size_t
+myconcurrent_vector<T, BaseShiftT>::grow_by( size_t n, const T & value ) {
+    const size_t i = _size.fetch_add( n, std::memory_order_relaxed );
+    if( !n ) return i;
+    unsigned k;
+    size_t o;
+    Indexing::decompose( i, k, o );
+    for( size_t left = n; left; ) {
+        T * b = _block(k);
+        const size_t bs = Indexing::block_size(k);
+        for( ; o < bs && left; ++o, --left ) {
+            new (b + o) T(value);
+        }
+        ++k;
+        o = 0;
+    }
+    return i;
+}
+
+template<typename T, unsigned BaseShiftT> void
+myconcurrent_vector<T, BaseShiftT>::reserve( size_t n ) {
+    for( unsigned k = 0; Indexing::block_begin(k) < n; ++k ) {
+        _block(k);
+    }
+}
+
+template<typename T, unsigned BaseShiftT> void
+myconcurrent_vector<T, BaseShiftT>::clear() {
+    const size_t n = _size.load( std::memory_order_acquire );
+    for( size_t i = 0; i < n; ++i ) {
+        _ptr(i)->~T();
+    }
+    for( unsigned k = 0; k < nBlocksMax; ++k ) {
+        T * b = _blocks[k].exchange( nullptr_C11, std::memory_order_acq_rel );
+        if( b ) {
+            ::operator delete( b );
+        }
+    }
+    _size.store( 0, std::memory_order_release );
+}
+
+# endif  // H_RDUS_MYCONCVEC_H
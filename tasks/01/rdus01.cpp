@@ -1,10 +1,13 @@
 # include "rdus01.h"
+# include "segvector.h"
 
 # include <iostream>
 # include <cstring>
 # include <cassert>
 # include <cstdio>
 # include <vector>
+# include <deque>
+# include <algorithm>
 
 # ifdef _ENABLE_TIMING
 #include <stdio.h>
@@ -153,8 +156,138 @@ test_suite( const size_t N ) {
     return 0;
 }
 
+//
+// Bulk operations adapters (C++11 STL has no erase_if() and no swap_erase())
+
+template<typename T> void
+bulk_append( std::vector<T> & v, const T * b, const T * e ) {
+    v.insert( v.end(), b, e );
+}
+
+template<typename T> void
+bulk_append( myvector<T> & v, const T * b, const T * e ) {
+    v.append( b, e );
+}
+
+template<typename T, typename PredT> int
+bulk_erase_if( std::vector<T> & v, PredT pred ) {
+    size_t n = v.size();
+    v.erase( std::remove_if( v.begin(), v.end(), pred ), v.end() );
+    return n - v.size();
+}
+
+template<typename T, typename PredT> int
+bulk_erase_if( myvector<T> & v, PredT pred ) {
+    return v.erase_if( pred );
+}
+
+template<typename T> void
+bulk_swap_erase( std::vector<T> & v, size_t i ) {
+    v[i] = v.back();
+    v.pop_back();
+}
+
+template<typename T> void
+bulk_swap_erase( myvector<T> & v, size_t i ) {
+    v.swap_erase( i );
+}
+
+struct IsOdd {
+    template<typename T> bool operator()( T & x ) const {
+        return (x - 0) & 0x1;
+    }
+};
+
+/// Does the same as test_suite() using bulk operations: fills container in
+/// chunks, repeats the interleaved push/erase pattern with pushes between
+/// erasures batched, then compacts with erase_if() and drains container with
+/// swap_erase().
+template<template<typename T> class ContainerT, typename T> int
+test_suite_bulk( const size_t N ) {
+    ContainerT<T> v;
+    std::vector<T> chunk;
+    const size_t chunkSize = 10;
+
+    for( size_t i = 0; i < N; ) {
+        chunk.clear();
+        for( ; i < N && chunk.size() < chunkSize; ++i ) {
+            chunk.push_back(T(N-i));
+        }
+        bulk_append( v, chunk.data(), chunk.data() + chunk.size() );
+    }
+    {
+        int i = N;
+        for( typename ContainerT<T>::iterator it = v.begin(); v.end() != it; ++it, --i ) {
+            if( *it - i ) {
+                std::cerr << "Integrity check failure: "
+                          << *it << " != " << i
+                          << std::endl;
+                return -1;
+            }
+        }
+    }
+
+    v.clear();
+
+    for( size_t i = 0; i < N; ) {
+        // test_suite() erases after each i%10 == 0 push (except first one)
+        const size_t nextErase = i ? ((i + 9)/10)*10 : 10;
+        chunk.clear();
+        for( ; i < N && i <= nextErase; ++i ) {
+            chunk.push_back(T(N-i));
+        }
+        bulk_append( v, chunk.data(), chunk.data() + chunk.size() );
+        if( i - 1 == nextErase ) {
+            v.erase( v.begin() + nextErase/2 );
+        }
+    }
+    if( N && (size_t) v.size() != N - (N-1)/10 ) {
+        std::cerr << "Integrity check failure: size " << v.size()
+                  << " != " << N - (N-1)/10 << std::endl;
+        return -1;
+    }
+
+    bulk_erase_if( v, IsOdd() );
+    for( typename ContainerT<T>::iterator it = v.begin(); v.end() != it; ++it ) {
+        if( IsOdd()(*it) ) {
+            std::cerr << "Integrity check failure: "
+                      << *it << " is not erased" << std::endl;
+            return -1;
+        }
+    }
+
+    while( v.size() ) {
+        bulk_swap_erase( v, 0 );
+    }
+    return 0;
+}
+
+/// Fills container with N bytes (mind the size, more than 4Gb by default)
+/// one push_back() at a time and checks strided elements. No erasures here.
+template<template<typename T> class ContainerT> int
+test_suite_large( const size_t N ) {
+    ContainerT<uint8_t> v;
+    for( size_t i = 0; i < N; ++i ) {
+        v.push_back( (uint8_t) (i*0x9e37) );
+    }
+    if( v.size() != N ) {
+        std::cerr << "Integrity check failure: size " << v.size()
+                  << " != " << N << std::endl;
+        return -1;
+    }
+    for( size_t i = 0; i < N; i += 4093 ) {
+        if( v[i] != (uint8_t) (i*0x9e37) ) {
+            std::cerr << "Integrity check failure at #" << i << std::endl;
+            return -1;
+        }
+    }
+    return 0;
+}
+
 template<typename T> using stlvec = std::vector<T>;
 template<typename T> using myvec = myvector<T>;
+template<typename T> using stldeque = std::deque<T>;
+template<typename T> using segvec = mysegvector<T>;
 
 class ImNotAPOD {
 private:
@@ -221,7 +354,7 @@ int
 main( int argc, char * const argv[] ) {
     if(argc != 2) {
         std::cerr << "Usage:" << std::endl
-                  << "    $ " << argv[0] << "[a|A|b|B|b|B|b]" << std::endl
+                  << "    $ " << argv[0] << "[a|A|b|B|c|C|d|D|e|E|l|L]" << std::endl
                   ;
         return EXIT_FAILURE;
     }
@@ -248,6 +381,18 @@ main( int argc, char * const argv[] ) {
         test_suite<stlvec, ImNotAPOD>( 1e4 );
     } else if( 'C' == argv[1][0] ) {
         test_suite<myvec, ImNotAPOD>( 1e4 );
+    } else if( 'd' == argv[1][0] ) {
+        test_suite_bulk<stlvec, int>( INT_MAX/4e3 );
+    } else if( 'D' == argv[1][0] ) {
+        test_suite_bulk<myvec, int>( INT_MAX/4e3 );
+    } else if( 'l' == argv[1][0] ) {
+        test_suite_large<stlvec>( (size_t(1) << 32) + (size_t(1) << 28) );
+    } else if( 'L' == argv[1][0] ) {
+        test_suite_large<myvec>( (size_t(1) << 32) + (size_t(1) << 28) );
+    } else if( 'e' == argv[1][0] ) {
+        test_suite<stldeque, ImNotAPOD>( 1e4 );
+    } else if( 'E' == argv[1][0] ) {
+        test_suite<segvec, ImNotAPOD>( 1e4 );
     }
     # ifdef _ENABLE_TIMING
     llong ended = microtimer();
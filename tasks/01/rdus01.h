@@ -4,7 +4,18 @@
 # include <cstdlib>
 # include <stdexcept>
 # include <climits>
+# include <cstdint>
 # include <cassert>
+# include <cstring>
+# include <algorithm>
+# include <iterator>
+# include <new>
+# if __cplusplus > 199711L
+# include <type_traits>
+# endif
+# ifdef _MSC_VER
+# include <malloc.h>
+# endif
 
 # if __cplusplus <= 199711L
 # define nullptr_C11 NULL
@@ -33,35 +44,56 @@ public:
                  _reservedEnd(nullptr_C11) {}
 	~myvector() { clear(); }
 
-	int capacity() { return _reservedEnd - _data; }
-	int size() { return _end - _data; }
+	size_t capacity() const { return _reservedEnd - _data; }
+	size_t size() const { return _end - _data; }
 
 	void add(const T & value); // because we can
 	T & add(); // easy handmade emplace_back()
-	void erase(int index); // easy handmade erase()
+	void erase(size_t index); // easy handmade erase()
 
 	void push_back(const T & value); // for test compatibility
 	void erase(const T * item); // for test compatibility
 
-	T & operator[](int index) {
-            return at(index); }
-	const T & operator[](int index) const {
-            return at(index); }
+    // Unchecked access (use at() for the checked one)
+	T & operator[](size_t index) {
+            assert( index < size() );
+            return _data[index]; }
+	const T & operator[](size_t index) const {
+            assert( index < size() );
+            return _data[index]; }
 
 	T * begin() { return _data; }
 	T * end() { return _end; }
 
 	void clear();
-	void resize(int new_size);
-	void reserve(int min_capacity);
+	void resize(size_t new_size);
+	void reserve(size_t min_capacity);
     // ^^^ end of required interface
 public:
     // sugar/helpers/aux...
-    const T & at( int index ) const;
-    T & at( int index ) {
+    const T & at( size_t index ) const;
+    T & at( size_t index ) {
         const Self * cSelf = this;
         return const_cast<T&>( cSelf->at(index) ); }
-	int size() const { return _end - _data; }
+
+    // Bulk operations. Source range must not refer to this vector's
+    // elements (as with STL, these are invalidated by reallocation).
+
+    /// Inserts [first, last) before pos with at most one reallocation.
+    /// Returns pointer to the first inserted element.
+    template<typename ItT> T * insert( const T * pos, ItT first, ItT last );
+    /// Appends [first, last) with at most one reallocation.
+    template<typename ItT> void append( ItT first, ItT last ) {
+        insert( _end, first, last ); }
+    /// Erases [first, last) shifting the tail once; returns first.
+    T * erase( const T * first, const T * last );
+    /// Erases all elements matching predicate in single compacting pass.
+    /// Returns number of erased elements.
+    template<typename PredT> size_t erase_if( PredT pred );
+    /// O(1) erase that does not preserve the order: the last element is
+    /// moved into erased one's place.
+    void swap_erase( const T * item );
+    void swap_erase( size_t index ) { swap_erase( &(at(index)) ); }
 };  // myvector
 
 template<typename T, typename AllocatorT> void
@@ -76,7 +108,7 @@ myvector<T, AllocatorT>::add() {
 }
 
 template<typename T, typename AllocatorT> void
-myvector<T, AllocatorT>::erase( int index ) {
+myvector<T, AllocatorT>::erase( size_t index ) {
     erase( &(at(index)) );
 }
 
@@ -91,7 +123,7 @@ myvector<T, AllocatorT>::push_back(const T & value) {
 // meaningful stuff:
 
 template<typename T, typename AllocatorT> const T &
-myvector<T, AllocatorT>::at( int index ) const {
+myvector<T, AllocatorT>::at( size_t index ) const {
     assert( _data );
     if(!(size() > index)) {
         throw std::out_of_range( "Custom vector index overflow." );
@@ -101,7 +133,7 @@ myvector<T, AllocatorT>::at( int index ) const {
 
 template<typename T, typename AllocatorT> void
 myvector<T, AllocatorT>::erase(const T * item) {
-    if( item > _end || item < _data ) {
+    if( item >= _end || item < _data ) {
         throw std::out_of_range( "Invalid element ptr to be erased." );
     }
     AllocatorT::erase_one( _data, const_cast<T*>(item), _end );
@@ -109,17 +141,81 @@ myvector<T, AllocatorT>::erase(const T * item) {
 
 template<typename T, typename AllocatorT> void
 myvector<T, AllocatorT>::clear() {
-    AllocatorT::clear( _reservedBgn );
+    AllocatorT::clear( _reservedBgn, _reservedEnd );
     _data = _end = _reservedBgn = _reservedEnd = nullptr_C11;
 }
 
+template<typename T, typename AllocatorT> template<typename ItT> T *
+myvector<T, AllocatorT>::insert( const T * pos, ItT first, ItT last ) {
+    if( pos > _end || pos < _data ) {
+        throw std::out_of_range( "Invalid insertion position." );
+    }
+    const size_t off = pos - _data,
+                 sz = size(),
+                 n = std::distance( first, last );
+    if( !n ) return _data + off;
+    if( n > PTRDIFF_MAX/sizeof(T) - sz ) {
+        throw std::length_error( "Custom vector size overflow." );
+    }
+    if( capacity() < sz + n ) {
+        reserve( sz + n );
+    }
+    AllocatorT::move_range( _data + off + n, _data + off, sz - off );
+    std::copy( first, last, _data + off );
+    _end = _data + sz + n;
+    return _data + off;
+}
+
+template<typename T, typename AllocatorT> T *
+myvector<T, AllocatorT>::erase( const T * first, const T * last ) {
+    if( first > last || first < _data || last > _end ) {
+        throw std::out_of_range( "Invalid range to be erased." );
+    }
+    T * f = const_cast<T*>(first);
+    AllocatorT::move_range( f, last, _end - last );
+    _end -= last - first;
+    return f;
+}
+
+template<typename T, typename AllocatorT> template<typename PredT> size_t
+myvector<T, AllocatorT>::erase_if( PredT pred ) {
+    // Moves runs of kept elements, so predicate is evaluated exactly once
+    // per element and each survivor is moved at most once.
+    T * w = _data,
+      * r = _data;
+    while( r != _end ) {
+        while( r != _end && pred(*r) ) ++r;
+        T * runBgn = r;
+        while( r != _end && !pred(*r) ) ++r;
+        if( w != runBgn ) {
+            AllocatorT::move_range( w, runBgn, r - runBgn );
+        }
+        w += r - runBgn;
+    }
+    const size_t nErased = _end - w;
+    _end = w;
+    return nErased;
+}
+
+template<typename T, typename AllocatorT> void
+myvector<T, AllocatorT>::swap_erase( const T * item ) {
+    if( item >= _end || item < _data ) {
+        throw std::out_of_range( "Invalid element ptr to be erased." );
+    }
+    --_end;
+    if( item != _end ) {
+        *const_cast<T*>(item) = *_end;
+    }
+}
+
 template<typename T, typename AllocatorT> void
-myvector<T, AllocatorT>::resize(int new_size) {
+myvector<T, AllocatorT>::resize(size_t new_size) {
     AllocatorT::reallocate( _data, _end, _reservedBgn, _reservedEnd, new_size );
+    _end = _data + new_size;
 }
 
 template<typename T, typename AllocatorT> void
-myvector<T, AllocatorT>::reserve(int min_capacity) {
+myvector<T, AllocatorT>::reserve(size_t min_capacity) {
     AllocatorT::reallocate( _data, _end, _reservedBgn, _reservedEnd, min_capacity );
 }
 
@@ -129,14 +225,29 @@ myvector<T, AllocatorT>::reserve(int min_capacity) {
 
 template<typename T>
 struct DefaultAllocator12 {
+    /// Moves n elements from src to (possibly overlapping) dst. Uses
+    /// memmove() for trivially copyable types.
+    static void move_range( T * dst, const T * src, size_t n ) {
+        if( !n || dst == src ) return;
+        # if __cplusplus > 199711L
+        if( std::is_trivially_copyable<T>::value ) {
+            memmove( (void *) dst, (const void *) src, n*sizeof(T) );
+            return;
+        }
+        # endif
+        if( dst < src ) {
+            std::copy( src, src + n, dst );
+        } else {
+            std::copy_backward( src, src + n, dst + n );
+        }
+    }
+
     static void erase_one( T *& bgn, T * item, T *& dEnd ) {
         // Deletes a particular element inside a block of memory
         // preserving the integrity of the remained sequence.
         T * cc = item;
         if( item - bgn <= dEnd - bgn ) {
-            for( T * c = item + 1; c != dEnd; ++c, ++cc ) {
-                *cc = *c;
-            }
+            move_range( item, item + 1, dEnd - item - 1 );
             --dEnd;
         } else {
             for( T * c = item - 1; c >= bgn; --c, --cc ) {
@@ -146,13 +257,15 @@ struct DefaultAllocator12 {
         }
     }
     
-    static void clear( T * dat ) {
+    static void clear( T * dat, T * /*rEnd*/ ) {
         delete [] dat;
     }
 
-    static void reallocate( T *& bgn, T *& dEnd, T *& rBgn, T *& rEnd, int n ) {
-        if(!(rEnd - bgn < n)) return;
-        int nn;
+    /// Ensures capacity for n elements, keeping size.
+    static void reallocate( T *& bgn, T *& dEnd, T *& rBgn, T *& rEnd, size_t n ) {
+        if(!((size_t) (rEnd - bgn) < n)) return;
+        const size_t sz = dEnd - bgn;
+        size_t nn;
         T * newdat = new T [nn = fine_block_size(rEnd - rBgn, n)];
         if( bgn ) {
             //memcpy( newdat, bgn, sizeof(T)*(dEnd - bgn) );  // good only for POD
@@ -167,20 +280,25 @@ struct DefaultAllocator12 {
             // FIXME: according to STL, new objects at reserved space has to
             // be _inserted_ apparently meaning that for POD type they have to
             // be initially set to zero.
-            clear( rBgn );
+            clear( rBgn, rEnd );
         }
         rBgn = bgn = newdat;
         rEnd = bgn + nn;
-        dEnd = bgn + n - 1;
+        dEnd = bgn + sz;
     }
 
-    static size_t fine_block_size( int oldSize, size_t newSize ) {
-        if( newSize >= INT_MAX ) {
+    static size_t fine_block_size( size_t oldSize, size_t newSize ) {
+        // Pointer difference must be representable, so it is the limit:
+        const size_t maxSize = PTRDIFF_MAX/sizeof(T);
+        if( newSize > maxSize ) {
             throw std::bad_alloc();  // Bad reallocation block size requested.
         }
         // FIXME: precious magic numbers:
         if( newSize < 32 ) {
             return 32;
+        } else if( newSize > (maxSize - 8)/2 ) {
+            // doubling would overflow, so fall back to exact size
+            return newSize;
         } else {
             newSize *= 2;
             return (newSize-newSize%8)+8;
@@ -188,4 +306,70 @@ struct DefaultAllocator12 {
     }
 };
 
+//
+// Over-aligned allocation strategy with the same growth law. The block
+// starts at AlignmentT-byte boundary and reserved capacity is padded up to a
+// whole number of AlignmentT-byte lines, so the full-width vector load
+// started at any aligned address before end() never leaves the block (values
+// beyond end() are unspecified, though).
+
+template<typename T, size_t AlignmentT>
+struct AlignedAllocator12 : public DefaultAllocator12<T> {
+    static void * allocate_aligned( size_t nBytes ) {
+        void * p;
+        # ifdef _MSC_VER
+        if( !(p = _aligned_malloc( nBytes, AlignmentT )) ) {
+            throw std::bad_alloc();
+        }
+        # else
+        if( posix_memalign( &p, AlignmentT, nBytes ) ) {
+            throw std::bad_alloc();
+        }
+        # endif
+        return p;
+    }
+
+    static void clear( T * dat, T * rEnd ) {
+        if( !dat ) return;
+        for( T * c = dat; c != rEnd; ++c ) {
+            c->~T();
+        }
+        # ifdef _MSC_VER
+        _aligned_free( dat );
+        # else
+        free( dat );
+        # endif
+    }
+
+    static void reallocate( T *& bgn, T *& dEnd, T *& rBgn, T *& rEnd, size_t n ) {
+        assert( !(AlignmentT & (AlignmentT - 1)) );  // power of two only
+        assert( !(AlignmentT % sizeof(void*)) );  // posix_memalign() reqs
+        if(!((size_t) (rEnd - bgn) < n)) return;
+        const size_t sz = dEnd - bgn;
+        size_t nn = DefaultAllocator12<T>::fine_block_size(rEnd - rBgn, n);
+        // pad capacity up to the alignment boundary:
+        while( (nn*sizeof(T)) % AlignmentT ) ++nn;
+        T * newdat = (T *) allocate_aligned( nn*sizeof(T) );
+        // Mimics default `new T[]' behaviour: every reserved element is
+        // default-initialized.
+        for( T * c = newdat; c != newdat + nn; ++c ) {
+            new (c) T;
+        }
+        if( bgn ) {
+            std::copy( bgn, dEnd, newdat );
+            clear( rBgn, rEnd );
+        }
+        rBgn = bgn = newdat;
+        rEnd = bgn + nn;
+        dEnd = bgn + sz;
+    }
+};
+
+# if __cplusplus > 199711L
+/// Vector which buffer is aligned at AlignmentT boundary (e.g. 32 for AVX,
+/// 64 for cache line and AVX-512).
+template<typename T, size_t AlignmentT=64>
+using myvector_aligned = myvector<T, AlignedAllocator12<T, AlignmentT> >;
+# endif
+
 # endif  // H_RDUS_MYVEC_H
@@ -0,0 +1,290 @@
+# ifndef H_RDUS_MYSEGVEC_H
+# define H_RDUS_MYSEGVEC_H
+
+# include <cstdlib>
+# include <cstddef>
+# include <stdexcept>
+# include <cassert>
+# include <new>
+
+# if __cplusplus <= 199711L
+# define nullptr_C11 NULL
+# else
+# define nullptr_C11 nullptr
+# endif
+
+//
+// Index arithmetic of geometrically growing blocks of B, 2B, 4B, ...
+// elements (B = 2^BaseShiftT). Index i maps to block k and offset o with no
+// loops or divisions:
+//      j = i + B,  h = floor(log2(j)),  k = h - BaseShiftT,  o = j - 2^h
+
+template<unsigned BaseShiftT>
+struct SegmentedIndexing {
+    static const unsigned nBlocksMax = 8*sizeof(size_t) - BaseShiftT;
+    static const size_t baseBlockSize = size_t(1) << BaseShiftT;
+
+    static unsigned log2( size_t j ) {
+        # ifdef __GNUC__
+        return 8*sizeof(unsigned long long) - 1 - __builtin_clzll(j);
+        # else
+        unsigned h = 0;
+        while( j >>= 1 ) ++h;
+        return h;
+        # endif
+    }
+    /// Number of elements in k-th block.
+    static size_t block_size( unsigned k ) { return baseBlockSize << k; }
+    /// Index of the first element in k-th block (= capacity of k blocks).
+    static size_t block_begin( unsigned k ) {
+        return baseBlockSize*((size_t(1) << k) - 1); }
+    static void decompose( size_t i, unsigned & k, size_t & o ) {
+        const size_t j = i + baseBlockSize;
+        const unsigned h = log2(j);
+        k = h - BaseShiftT;
+        o = j - (size_t(1) << h);
+    }
+};
+
+//
+// Segmented vector: elements live in the geometrically growing blocks
+// referenced by a small fixed block index (see SegmentedIndexing). Growth
+// only appends new blocks, so existing elements are never relocated and
+// pointers/references to them stay valid until the element is erased
+// (erasure shifts the tail as myvector does).
+//
+// Unlike myvector, reserved but unused space holds no constructed objects.
+
+template<typename T, unsigned BaseShiftT=4>
+class mysegvector {
+public:
+    typedef mysegvector<T, BaseShiftT> Self;
+    typedef SegmentedIndexing<BaseShiftT> Indexing;
+    static const unsigned nBlocksMax = Indexing::nBlocksMax;
+    static const size_t baseBlockSize = Indexing::baseBlockSize;
+
+    /// Iterator caches pointer to current element and end of its block, so
+    /// sequential traversal is a pointer increment most of the times.
+    class iterator {
+    private:
+        Self * _v;
+        size_t _i;
+        T * _p,
+          * _blockEnd;
+        void _locate() { _v->_locate( _i, _p, _blockEnd ); }
+    public:
+        iterator() : _v(nullptr_C11), _i(0),
+                     _p(nullptr_C11), _blockEnd(nullptr_C11) {}
+        iterator( Self * v, size_t i ) : _v(v), _i(i) { _locate(); }
+
+        T & operator*() const { assert(_p); return *_p; }
+        T * operator->() const { assert(_p); return _p; }
+
+        iterator & operator++() {
+            ++_i;
+            if( ++_p == _blockEnd ) {
+                _locate();
+            }
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator r(*this);
+            ++(*this);
+            return r;
+        }
+        iterator operator+( ptrdiff_t n ) const { return iterator( _v, _i + n ); }
+        iterator operator-( ptrdiff_t n ) const { return iterator( _v, _i - n ); }
+        ptrdiff_t operator-( const iterator & o ) const { return _i - o._i; }
+
+        size_t index() const { return _i; }
+
+        friend bool operator!= (const iterator & l,
+                                const iterator & r) { return l._i != r._i; }
+        friend bool operator== (const iterator & l,
+                                const iterator & r) { return ! (l != r); }
+    };
+private:
+    T * _blocks[nBlocksMax];
+    unsigned _nBlocks;
+    size_t _size;
+protected:
+    static size_t _block_size( unsigned k ) { return Indexing::block_size(k); }
+    /// Sets p to element i and blockEnd to the end of its block. Both are
+    /// null if the block was not allocated yet.
+    void _locate( size_t i, T *& p, T *& blockEnd ) const {
+        unsigned k;
+        size_t o;
+        Indexing::decompose( i, k, o );
+        if( k < _nBlocks ) {
+            p = _blocks[k] + o;
+            blockEnd = _blocks[k] + _block_size(k);
+        } else {
+            p = blockEnd = nullptr_C11;
+        }
+    }
+    T * _ptr( size_t i ) const {
+        unsigned k;
+        size_t o;
+        Indexing::decompose( i, k, o );
+        return _blocks[k] + o;
+    }
+    /// Returns index of given element, or size() if it does not belong to
+    /// this container.
+    size_t _index_of( const T * item ) const;
+    /// Appends uninitialized blocks until capacity is at least n.
+    void _grow_to( size_t n );
+    /// Copy-constructs elements of o, must be empty.
+    void _copy_from( const Self & o );
+public:
+    // Interface of myvector:
+    mysegvector() : _nBlocks(0), _size(0) {}
+    mysegvector( const Self & o ) : _nBlocks(0), _size(0) { _copy_from( o ); }
+    # if __cplusplus > 199711L
+    /// Takes the blocks of o, leaving it empty.
+    mysegvector( Self && o ) : _nBlocks(o._nBlocks), _size(o._size) {
+        for( unsigned k = 0; k < _nBlocks; ++k ) {
+            _blocks[k] = o._blocks[k];
+        }
+        o._nBlocks = 0;
+        o._size = 0;
+    }
+    # endif
+    ~mysegvector() { clear(); }
+
+    Self & operator=( const Self & o ) {
+        if( this != &o ) {
+            resize( 0 );
+            _copy_from( o );
+        }
+        return *this;
+    }
+
+    size_t capacity() const { return Indexing::block_begin(_nBlocks); }
+    size_t size() const { return _size; }
+
+    void add(const T & value) { push_back(value); }
+    T & add();
+    void erase(size_t index) { erase( &(at(index)) ); }
+
+    void push_back(const T & value);
+    void erase(const T * item);
+    void erase(const iterator & it) { erase( &(at(it.index())) ); }
+
+    // Unchecked access (use at() for the checked one)
+    T & operator[](size_t index) {
+            assert( index < size() );
+            return *_ptr(index); }
+    const T & operator[](size_t index) const {
+            assert( index < size() );
+            return *_ptr(index); }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, _size); }
+
+    void clear();
+    void resize(size_t new_size);
+    void reserve(size_t min_capacity) { _grow_to( min_capacity ); }
+
+    const T & at( size_t index ) const {
+        if(!(_size > index)) {
+            throw std::out_of_range( "Segmented vector index overflow." );
+        }
+        return *_ptr(index);
+    }
+    T & at( size_t index ) {
+        const Self * cSelf = this;
+        return const_cast<T&>( cSelf->at(index) ); }
+};  // mysegvector
+
+template<typename T, unsigned BaseShiftT> void
+mysegvector<T, BaseShiftT>::_grow_to( size_t n ) {
+    while( capacity() < n ) {
+        if( _nBlocks == nBlocksMax ) {
+            throw std::bad_alloc();
+        }
+        _blocks[_nBlocks] = static_cast<T*>(
+                ::operator new( sizeof(T)*_block_size(_nBlocks) ) );
+        ++_nBlocks;
+    }
+}
+
+template<typename T, unsigned BaseShiftT> void
+mysegvector<T, BaseShiftT>::_copy_from( const Self & o ) {
+    assert( !_size );
+    _grow_to( o._size );
+    for( ; _size < o._size; ++_size ) {
+        new (_ptr(_size)) T(*o._ptr(_size));
+    }
+}
+
+template<typename T, unsigned BaseShiftT> size_t
+mysegvector<T, BaseShiftT>::_index_of( const T * item ) const {
+    for( unsigned k = 0; k < _nBlocks; ++k ) {
+        if( item >= _blocks[k] && item < _blocks[k] + _block_size(k) ) {
+            size_t i = Indexing::block_begin(k) + (item - _blocks[k]);
+            return i < _size ? i : _size;
+        }
+    }
+    return _size;
+}
+
+template<typename T, unsigned BaseShiftT> void
+mysegvector<T, BaseShiftT>::push_back( const T & value ) {
+    if( _size == capacity() ) {
+        _grow_to( _size + 1 );
+    }
+    new (_ptr(_size)) T(value);
+    ++_size;
+}
+
+template<typename T, unsigned BaseShiftT> T &
+mysegvector<T, BaseShiftT>::add() {
+    if( _size == capacity() ) {
+        _grow_to( _size + 1 );
+    }
+    T * p = new (_ptr(_size)) T();
+    ++_size;
+    return *p;
+}
+
+template<typename T, unsigned BaseShiftT> void
+mysegvector<T, BaseShiftT>::erase( const T * item ) {
+    size_t i = _index_of( item );
+    if( i == _size ) {
+        throw std::out_of_range( "Invalid element ptr to be erased." );
+    }
+    // shift the tail block by block
+    T * p, * blockEnd;
+    _locate( i, p, blockEnd );
+    for( ++i; i < _size; ++i ) {
+        T * dst = p;
+        if( ++p == blockEnd ) {
+            _locate( i, p, blockEnd );
+        }
+        *dst = *p;
+    }
+    p->~T();
+    --_size;
+}
+
+template<typename T, unsigned BaseShiftT> void
+mysegvector<T, BaseShiftT>::resize( size_t new_size ) {
+    _grow_to( new_size );
+    for( ; _size < new_size; ++_size ) {
+        new (_ptr(_size)) T();
+    }
+    for( ; _size > new_size; --_size ) {
+        _ptr(_size - 1)->~T();
+    }
+}
+
+template<typename T, unsigned BaseShiftT> void
+mysegvector<T, BaseShiftT>::clear() {
+    resize( 0 );
+    for( unsigned k = 0; k < _nBlocks; ++k ) {
+        ::operator delete( _blocks[k] );
+    }
+    _nBlocks = 0;
+}
+
+# endif  // H_RDUS_MYSEGVEC_H
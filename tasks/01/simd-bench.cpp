@@ -0,0 +1,193 @@
+# include "rdus01.h"
+
+# include <iostream>
+# include <cstdlib>
+# include <cstdio>
+# include <cmath>
+# include <vector>
+# include <chrono>
+
+# include <immintrin.h>
+
+//
+// Vectorized sum/transform over over-aligned myvector buffer versus the same
+// routines over the unaligned one.
+//
+// Aligned variant loads full-width vectors even across the end() (masking
+// the garbage lanes for reduction) and needs no scalar tail loop at all.
+// Unaligned variant has to use loadu/storeu and finish with scalar tail.
+//
+// Build with, e.g.:
+//  $ g++ -std=c++11 -O2 -mavx2 simd-bench.cpp -o simd-bench
+// (drop -mavx2 to benchmark 16-byte SSE path).
+
+# if defined(__AVX__)
+typedef __m256 VecF;
+static const size_t gW = 8;
+# define vec_load(p)        _mm256_load_ps(p)
+# define vec_loadu(p)       _mm256_loadu_ps(p)
+# define vec_store(p, v)    _mm256_store_ps(p, v)
+# define vec_storeu(p, v)   _mm256_storeu_ps(p, v)
+# define vec_add(a, b)      _mm256_add_ps(a, b)
+# define vec_mul(a, b)      _mm256_mul_ps(a, b)
+# define vec_and(a, b)      _mm256_and_ps(a, b)
+# define vec_set1(a)        _mm256_set1_ps(a)
+# define vec_zero()         _mm256_setzero_ps()
+# define vec_lt(a, b)       _mm256_cmp_ps(a, b, _CMP_LT_OQ)
+# define vec_iota()         _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7)
+static float vec_hsum( VecF v ) {
+    __m128 l = _mm256_castps256_ps128(v),
+           h = _mm256_extractf128_ps(v, 1);
+    l = _mm_add_ps(l, h);
+    l = _mm_hadd_ps(l, l);
+    l = _mm_hadd_ps(l, l);
+    return _mm_cvtss_f32(l);
+}
+# else
+typedef __m128 VecF;
+static const size_t gW = 4;
+# define vec_load(p)        _mm_load_ps(p)
+# define vec_loadu(p)       _mm_loadu_ps(p)
+# define vec_store(p, v)    _mm_store_ps(p, v)
+# define vec_storeu(p, v)   _mm_storeu_ps(p, v)
+# define vec_add(a, b)      _mm_add_ps(a, b)
+# define vec_mul(a, b)      _mm_mul_ps(a, b)
+# define vec_and(a, b)      _mm_and_ps(a, b)
+# define vec_set1(a)        _mm_set1_ps(a)
+# define vec_zero()         _mm_setzero_ps()
+# define vec_lt(a, b)       _mm_cmplt_ps(a, b)
+# define vec_iota()         _mm_setr_ps(0, 1, 2, 3)
+static float vec_hsum( VecF v ) {
+    float r[4];
+    _mm_storeu_ps( r, v );
+    return r[0] + r[1] + r[2] + r[3];
+}
+# endif
+
+typedef myvector_aligned<float, 64> AlignedFloats;
+
+static float
+sum_aligned( const float * b, const float * e ) {
+    VecF acc = vec_zero();
+    const float * p = b;
+    for( ; p + gW <= e; p += gW ) {
+        acc = vec_add( acc, vec_load(p) );
+    }
+    if( p < e ) {
+        // safe: tail padding guarantees the line is within the block
+        VecF m = vec_lt( vec_iota(), vec_set1( (float) (e - p) ) );
+        acc = vec_add( acc, vec_and( vec_load(p), m ) );
+    }
+    return vec_hsum(acc);
+}
+
+static float
+sum_unaligned( const float * b, const float * e ) {
+    VecF acc = vec_zero();
+    const float * p = b;
+    for( ; p + gW <= e; p += gW ) {
+        acc = vec_add( acc, vec_loadu(p) );
+    }
+    float r = vec_hsum(acc);
+    for( ; p < e; ++p ) {
+        r += *p;
+    }
+    return r;
+}
+
+static void
+transform_aligned( float * b, float * e, float a, float c ) {
+    const VecF va = vec_set1(a),
+               vc = vec_set1(c);
+    // writes beyond end() land into the padding and are harmless
+    for( float * p = b; p < e; p += gW ) {
+        vec_store( p, vec_add( vec_mul( vec_load(p), va ), vc ) );
+    }
+}
+
+static void
+transform_unaligned( float * b, float * e, float a, float c ) {
+    const VecF va = vec_set1(a),
+               vc = vec_set1(c);
+    float * p = b;
+    for( ; p + gW <= e; p += gW ) {
+        vec_storeu( p, vec_add( vec_mul( vec_loadu(p), va ), vc ) );
+    }
+    for( ; p < e; ++p ) {
+        *p = *p*a + c;
+    }
+}
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static double
+ns_per_elem( Clock::time_point s, Clock::time_point e, size_t nElems ) {
+    return std::chrono::duration<double, std::nano>(e - s).count() / nElems;
+}
+
+int
+main( int argc, char * const argv[] ) {
+    if( argc > 3 ) {
+        std::cerr << "Usage:" << std::endl
+                  << "    $ " << argv[0] << " [nElements [nRepeats]]" << std::endl
+                  ;
+        return EXIT_FAILURE;
+    }
+    // odd size by default to exercise the tail handling
+    const size_t N = argc > 1 ? strtoul( argv[1], NULL, 0 ) : 4093,
+                 nRepeats = argc > 2 ? strtoul( argv[2], NULL, 0 ) : 2e5/(1 + N/4093);
+
+    AlignedFloats av;
+    // unaligned buffer: shifted by one element from (at least) 16-byte
+    // boundary guaranteed by malloc()
+    std::vector<float> uStorage( N + 1 );
+    float * ub = uStorage.data() + 1,
+          * ue = ub + N;
+    for( size_t i = 0; i < N; ++i ) {
+        float v = (float) (i%17) - 8;
+        av.push_back( v );
+        ub[i] = v;
+    }
+    assert( !(((size_t) av.begin()) % 64) );
+    assert( ((size_t) ub) % 16 );
+
+    std::cout << "# width=" << gW*sizeof(float) << "B, N=" << N
+              << ", repeats=" << nRepeats << std::endl;
+
+    volatile float sink = 0;
+    Clock::time_point s, e;
+
+    s = Clock::now();
+    for( size_t r = 0; r < nRepeats; ++r ) sink = sink + sum_aligned( av.begin(), av.end() );
+    e = Clock::now();
+    std::cout << "sum, aligned:         " << ns_per_elem( s, e, N*nRepeats ) << " ns/elem" << std::endl;
+
+    s = Clock::now();
+    for( size_t r = 0; r < nRepeats; ++r ) sink = sink + sum_unaligned( ub, ue );
+    e = Clock::now();
+    std::cout << "sum, unaligned:       " << ns_per_elem( s, e, N*nRepeats ) << " ns/elem" << std::endl;
+
+    if( std::fabs( sum_aligned( av.begin(), av.end() ) - sum_unaligned( ub, ue ) ) > 1e-3*N ) {
+        std::cerr << "Integrity check failure: sums differ." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    s = Clock::now();
+    for( size_t r = 0; r < nRepeats; ++r ) transform_aligned( av.begin(), av.end(), 1.f, 1e-7f );
+    e = Clock::now();
+    std::cout << "transform, aligned:   " << ns_per_elem( s, e, N*nRepeats ) << " ns/elem" << std::endl;
+
+    s = Clock::now();
+    for( size_t r = 0; r < nRepeats; ++r ) transform_unaligned( ub, ue, 1.f, 1e-7f );
+    e = Clock::now();
+    std::cout << "transform, unaligned: " << ns_per_elem( s, e, N*nRepeats ) << " ns/elem" << std::endl;
+
+    for( size_t i = 0; i < N; ++i ) {
+        if( av[i] != ub[i] ) {
+            std::cerr << "Integrity check failure: " << av[i] << " != " << ub[i]
+                      << " at #" << i << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
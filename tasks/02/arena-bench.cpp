@@ -0,0 +1,165 @@
+# include <string>
+# include <vector>
+# include <iostream>
+# include <random>
+# include <chrono>
+# include <unordered_map>
+
+# include <cstdlib>
+# include <cstdio>
+# include <cstring>
+# include <unistd.h>
+# include <sys/wait.h>
+
+# include "arenahash.hpp"
+
+//
+// Vocabulary of nWords distinct words (6..20 letters, so a third of them
+// is longer than 15 bytes) mapped to their ids: myhash_arena<int> (inline
+// short keys, long ones in the arena) versus myhash<std::string, int> and
+// std::unordered_map<std::string, int>. Every table is built in a child
+// process of its own, reporting the growth of its resident set size (RSS,
+// /proc/self/status) over the baseline: after the build and the peak one
+// (growth included), build time and random lookup rates (million lookups
+// per second) of present and absent words.
+//
+// Words are generated from their index (6 letters of the index in base 26,
+// so they are distinct, followed by pseudo-random ones), so the vocabulary
+// itself takes no memory; absent words are the ones of indexes >= nWords.
+//
+// Usage:
+//  $ arena-bench [nWords [nQueries]]
+
+typedef std::chrono::high_resolution_clock Clock;
+typedef myhash_arena<int> ArenaHash;
+typedef myhash<std::string, int> Hash;
+typedef std::unordered_map<std::string, int> StdMap;
+
+/// Writes i-th word to buf (at least 20 bytes), returns its length.
+static size_t
+make_word( uint64_t i, char * buf ) {
+    uint64_t h = myhash_fmix64( i + 1 );
+    const size_t length = 6 + h % 15;
+    size_t n = 0;
+    for( uint64_t v = i; n < 6; ++n, v /= 26 ) {
+        buf[n] = 'a' + v % 26;
+    }
+    for( ; n < length; ++n ) {
+        h = h*6364136223846793005ULL + 1442695040888963407ULL;
+        buf[n] = 'a' + (h >> 33) % 26;
+    }
+    return length;
+}
+
+/// Returns field of /proc/self/status (VmRSS, VmHWM), in MB.
+static double
+status_mb( const char * field ) {
+    FILE * f = fopen( "/proc/self/status", "r" );
+    if( !f ) {
+        return 0;
+    }
+    char line[256];
+    double kb = 0;
+    const size_t l = strlen( field );
+    while( fgets( line, sizeof(line), f ) ) {
+        if( !strncmp( line, field, l ) && ':' == line[l] ) {
+            kb = atof( line + l + 1 );
+            break;
+        }
+    }
+    fclose( f );
+    return kb/1024;
+}
+
+static void
+insert_word( ArenaHash & t, const char * w, size_t l, int id ) {
+    t[myhash_string_ref( w, l )] = id; }
+static void
+insert_word( Hash & t, const char * w, size_t l, int id ) {
+    t[myhash_string_ref( w, l )] = id; }
+static void
+insert_word( StdMap & t, const char * w, size_t l, int id ) {
+    t[std::string( w, l )] = id; }
+
+template<typename TableT> double
+lookups_per_us( const TableT & t, const std::vector<std::string> & queries, long & sum ) {
+    Clock::time_point s = Clock::now();
+    for( size_t i = 0; i < queries.size(); ++i ) {
+        typename TableT::const_iterator it = t.find( queries[i] );
+        if( it != t.end() ) {
+            sum += it->second + 1;
+        }
+    }
+    return queries.size()/std::chrono::duration<double, std::micro>(Clock::now() - s).count();
+}
+
+/// Builds and queries the table, run in the child process.
+template<typename TableT> bool
+bench_vocabulary( const char * name, size_t nWords, size_t nQueries ) {
+    std::mt19937_64 rng(1337);
+    std::vector<std::string> hitQueries, missQueries;
+    long expected = 0;
+    char w[32];
+    for( size_t i = 0; i < nQueries; ++i ) {
+        const size_t n = rng() % nWords;
+        hitQueries.push_back( std::string( w, make_word( n, w ) ) );
+        missQueries.push_back( std::string( w, make_word( nWords + i, w ) ) );
+        expected += n + 1;
+    }
+    const double baseline = status_mb( "VmRSS" );
+
+    TableT t;
+    Clock::time_point s = Clock::now();
+    for( size_t i = 0; i < nWords; ++i ) {
+        insert_word( t, w, make_word( i, w ), (int) i );
+    }
+    const double buildS = std::chrono::duration<double>(Clock::now() - s).count(),
+                 rss = status_mb( "VmRSS" ) - baseline,
+                 peak = status_mb( "VmHWM" ) - baseline;
+    long sum = 0;
+    const double hits = lookups_per_us( t, hitQueries, sum ),
+                 misses = lookups_per_us( t, missQueries, sum );
+    if( (size_t) t.size() != nWords || sum != expected ) {
+        std::cerr << "Integrity check failure: " << name << ", " << t.size()
+                  << " entries, sum " << sum << " instead of " << expected << std::endl;
+        return false;
+    }
+    printf( "%-16s%10.1f%10.1f%10.1f%10.2f%10.2f%10.2f\n", name, rss, peak,
+            rss*1048576./nWords, buildS, hits, misses );
+    fflush( stdout );
+    return true;
+}
+
+/// Runs the benchmark of the table in the child process, so its memory is
+/// measured apart from the others.
+template<typename TableT> bool
+run_apart( const char * name, size_t nWords, size_t nQueries ) {
+    const pid_t pid = fork();
+    if( pid < 0 ) {
+        perror( "fork()" );
+        return false;
+    }
+    if( !pid ) {
+        _exit( bench_vocabulary<TableT>( name, nWords, nQueries ) ? EXIT_SUCCESS
+                                                                  : EXIT_FAILURE );
+    }
+    int status;
+    return waitpid( pid, &status, 0 ) == pid && WIFEXITED(status)
+        && EXIT_SUCCESS == WEXITSTATUS(status);
+}
+
+int
+main( int argc, const char * argv[] ) {
+    const size_t nWords = argc > 1 ? strtoul( argv[1], NULL, 0 ) : 20000000,
+                 nQueries = argc > 2 ? strtoul( argv[2], NULL, 0 ) : 2000000;
+    printf( "# %zu words, %zu queries, RSS growth in MB, Mlookups/s\n"
+            "%-16s%10s%10s%10s%10s%10s%10s\n", nWords, nQueries, "table",
+            "RSS", "peak", "B/word", "build,s", "hits", "misses" );
+    fflush( stdout );
+    if( !run_apart<ArenaHash>( "myhash_arena", nWords, nQueries )
+     || !run_apart<Hash>( "myhash", nWords, nQueries )
+     || !run_apart<StdMap>( "unordered_map", nWords, nQueries ) ) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
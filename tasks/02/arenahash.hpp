@@ -0,0 +1,459 @@
+# ifndef H_RDUS_MYHASH_ARENA_H
+# define H_RDUS_MYHASH_ARENA_H
+
+# include "rdus.hpp"
+
+# include <string>
+# include <vector>
+# include <utility>
+
+//
+// Open addressing hash for string keys without std::string in the slot.
+// The key takes 16 bytes of the slot (cf. 32 of std::string plus 16 of
+// myhash::HashEntry reference members):
+//  - keys of up to 15 bytes are stored inline, zero-padded, with the length
+//    in the last byte;
+//  - longer keys are interned into the append-only arena of large chunks,
+//    the slot keeps their offset and length (and 0xff in the last byte).
+// So the short keys are never allocated at all and the long ones are packed
+// together instead of being scattered over the heap by malloc. Each key has
+// single representation, so a short key is compared as two 64-bit words
+// (length included), a long one -- by its length and then by memcmp() of the
+// arena bytes.
+//
+// Probing is linear on the stored 31-bit hash (so growth does not re-hash
+// keys and most of the non-matching slots are rejected without touching the
+// key), erasure is backward-shift (no tombstones). Mind, that erasure moves
+// entries, so erasing while iterating may skip entries. The arena is never
+// compacted: bytes of erased long keys are not reclaimed until destruction.
+//
+// Values must be default-constructible (vacant slots hold value-initialized
+// ones) and move-assignable.
+//
+// Interface follows myhash (operator[], find(), insert(), increment(),
+// erase(), iterator with ->first/->second and ->key/->value); keys are given
+// as std::string, character sequence or myhash_string_ref, iterator gives
+// the key as myhash_string_ref.
+
+template<typename VALUE, typename HashT=myhash_default_hash<std::string> >
+class myhash_arena {
+public:
+    typedef uint32_t Size;
+    typedef uint32_t HashValue;
+    typedef std::string Key;
+    typedef VALUE Value;
+    typedef HashT Hash;
+    typedef myhash_arena<Value, Hash> Self;
+
+    static const Size inlineCapacity = 15;
+
+    /// Key of the slot: up to 15 inline chars and length in byte 15, or
+    /// arena offset (bytes 0..7), length (8..11) and externalTag in byte 15.
+    struct SlotKey {
+        static const uint8_t externalTag = 0xff;
+        uint64_t words[2];
+
+        const char * chars() const { return reinterpret_cast<const char *>(words); }
+        uint8_t tag() const { return reinterpret_cast<const uint8_t *>(words)[15]; }
+        bool is_inline() const { return tag() <= inlineCapacity; }
+        uint32_t length() const {
+            if( is_inline() ) return tag();
+            uint32_t l;
+            memcpy( &l, chars() + 8, sizeof(l) );
+            return l;
+        }
+        uint64_t offset() const { return words[0]; }
+        /// Sets inline key, l must not exceed inlineCapacity.
+        void set_inline( const char * data, size_t l ) {
+            words[0] = words[1] = 0;
+            memcpy( words, data, l );
+            reinterpret_cast<uint8_t *>(words)[15] = (uint8_t) l;
+        }
+        void set_external( uint64_t offset, uint32_t l ) {
+            words[0] = offset;
+            words[1] = 0;
+            memcpy( reinterpret_cast<char *>(words) + 8, &l, sizeof(l) );
+            reinterpret_cast<uint8_t *>(words)[15] = externalTag;
+        }
+    };
+
+    struct Slot {
+        SlotKey key;
+        HashValue hashValue;  // (hash << 1) | 1 if occupied, 0 if vacant
+        Value value;
+    };
+
+    /// Proxy returned by iterator dereference, ref members for spec
+    /// compat.
+    struct Reference {
+        myhash_string_ref first;
+        Value & second;
+        myhash_string_ref key;
+        Value & value;
+
+        Reference( myhash_string_ref k, Value & v ) :
+                    first(k), second(v), key(k), value(v) {}
+        /// Makes iterator's operator->() chain to the members.
+        Reference * operator->() { return this; }
+    };
+
+    struct iterator {
+        Slot * slot,
+             * slotsEnd;
+        const Self * table;  // to resolve arena offsets
+
+        iterator( Slot * s, Slot * sEnd, const Self * t ) :
+                    slot(s), slotsEnd(sEnd), table(t) {}
+
+        /// Moves to the next occupied slot (or to the end).
+        iterator & operator++() {
+            do { ++slot; } while( slot != slotsEnd && !slot->hashValue );
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator it(*this);
+            ++(*this);
+            return it;
+        }
+        Reference operator->() const {
+            return Reference( table->_key_ref( slot->key ), slot->value ); }
+        Reference operator*() const {
+            return Reference( table->_key_ref( slot->key ), slot->value ); }
+
+        friend bool operator!= (const iterator & l,
+                                const iterator & r) { return l.slot != r.slot; }
+        friend bool operator== (const iterator & l,
+                                const iterator & r) { return ! (l != r); }
+    };
+    typedef iterator const_iterator;
+private:
+    Slot * _table;
+    Size _tableSize,  // always a power of two
+         _fillmentThreshold,
+         _nOccupiedEntries
+         ;
+    float _maxLoadFactor;
+    uint8_t _growthShift;  // log2 of growth factor
+    // Arena: chunks of key bytes; offset of the key is chunk index in high
+    // 32 bits and position in the chunk in low ones.
+    std::vector<char *> _chunks;
+    size_t _lastChunkUsed,
+           _lastChunkCapacity,
+           _arenaBytes
+           ;
+protected:
+    static const size_t _chunkSize = 1 << 20;
+    static const Size _minTableSize = 8;
+    static HashValue _hash( const myhash_string_ref & r ) {
+        return myhash_fmix32( Hash::hash(r) ) >> 1; }
+    Size _home( HashValue hv ) const { return hv & (_tableSize - 1); }
+    Size _next( Size place ) const { return (place + 1) & (_tableSize - 1); }
+    const char * _arena_data( uint64_t offset ) const {
+        return _chunks[offset >> 32] + uint32_t(offset); }
+    myhash_string_ref _key_ref( const SlotKey & k ) const {
+        return k.is_inline() ? myhash_string_ref( k.chars(), k.tag() )
+                             : myhash_string_ref( _arena_data( k.offset() ), k.length() ); }
+    /// Copies key bytes to the arena, returns their offset.
+    uint64_t _intern( const char * data, uint32_t l );
+    iterator _iterator( Slot * s ) const {
+        return iterator( s, _table + _tableSize, this ); }
+    /// Returns slot of the key of given hash, or null and the vacant slot
+    /// where the probe stopped in place.
+    Slot * _probe( const myhash_string_ref & r, HashValue hv, Size & place ) const;
+    /// Returns slot of the key, or null.
+    Slot * _find( const myhash_string_ref & r ) const {
+        Size place;
+        return _probe( r, _hash(r), place ); }
+    /// Single-probe lookup with insertion of value constructed from args
+    /// on miss. Returns the slot and insertion flag.
+    template<typename ... ArgsT>
+    std::pair<Slot *, bool> _find_or_insert( const myhash_string_ref & r,
+                                             ArgsT && ... args );
+    void _update_threshold();
+    /// Re-builds the table of given size (power of two), using stored hashes.
+    void _rehash( Size newSize );
+public:
+    myhash_arena( float maxLoadFactor=0.7, Size growthFactor=2 );
+    ~myhash_arena();
+
+    myhash_arena( const Self & ) = delete;
+    Self & operator=( const Self & ) = delete;
+
+    Value & at( const myhash_string_ref & r ) { return _find_or_insert( r ).first->value; }
+    Value & at( const std::string & k ) { return at( myhash_string_ref(k) ); }
+    const Value & at( const myhash_string_ref & r ) const;
+    const Value & at( const std::string & k ) const { return at( myhash_string_ref(k) ); }
+    Value & operator[]( const myhash_string_ref & r ) { return at(r); }
+    Value & operator[]( const std::string & k ) { return at(k); }
+    Value & operator[]( const char * s ) { return at( myhash_string_ref(s) ); }
+    const Value & operator[]( const myhash_string_ref & r ) const { return at(r); }
+    const Value & operator[]( const std::string & k ) const { return at(k); }
+
+    /// Inserts (k, v) if k is absent. Returns iterator to the element with
+    /// key k and true if it was inserted.
+    std::pair<iterator, bool> insert( const myhash_string_ref & r, const Value & v ) {
+        std::pair<Slot *, bool> res = _find_or_insert( r, v );
+        return std::make_pair( _iterator( res.first ), res.second ); }
+    std::pair<iterator, bool> insert( const std::string & k, const Value & v ) {
+        return insert( myhash_string_ref(k), v ); }
+    /// Adds delta to the value of key k (inserting default value, if
+    /// absent). Returns reference to the updated value.
+    Value & increment( const myhash_string_ref & r, const Value & delta=Value(1) ) {
+        return _find_or_insert( r ).first->value += delta; }
+
+    iterator begin() const;
+    iterator end() const { return _iterator( _table + _tableSize ); }
+
+    iterator find( const myhash_string_ref & r ) const {
+        Slot * s = _find(r);
+        return s ? _iterator( s ) : end(); }
+    iterator find( const std::string & k ) const { return find( myhash_string_ref(k) ); }
+    iterator find( const char * s ) const { return find( myhash_string_ref(s) ); }
+    iterator find( const char * s, size_t l ) const { return find( myhash_string_ref(s, l) ); }
+
+    void erase( const myhash_string_ref & r ) { Slot * s = _find(r); if( s ) erase( _iterator(s) ); }
+    void erase( const std::string & k ) { erase( myhash_string_ref(k) ); }
+    void erase( const const_iterator & it );
+
+    int size() const { return (int) _nOccupiedEntries; }
+    Size table_size() const { return _tableSize; }
+    /// Bytes allocated for the arena chunks.
+    size_t arena_bytes() const { return _arenaBytes; }
+    /// Bytes allocated for the table and the arena (that is, all of it).
+    size_t allocated_bytes() const {
+        return sizeof(Slot)*size_t(_tableSize) + _arenaBytes
+             + sizeof(char *)*_chunks.capacity(); }
+    /// Makes room for n entries to be held without growth. Does not shrink.
+    void reserve( Size n );
+
+    float load_factor() const { return float(_nOccupiedEntries)/_tableSize; }
+    float max_load_factor() const { return _maxLoadFactor; }
+    /// Sets load factor (0, 1) that triggers growth. Does not shrink table.
+    void max_load_factor( float f );
+    Size growth_factor() const { return Size(1) << _growthShift; }
+    /// Sets table growth factor, must be a power of two >= 2.
+    void growth_factor( Size f );
+};  // class myhash_arena
+
+// Implementation
+////////////////
+
+template<typename VALUE, typename HashT>
+myhash_arena<VALUE, HashT>::myhash_arena( float maxLoadFactor,
+                                          Size growthFactor ) :
+                _table( nullptr_C11 ),
+                _tableSize( _minTableSize ),
+                _fillmentThreshold( 0 ),
+                _nOccupiedEntries( 0 ),
+                _maxLoadFactor( 0.7 ),
+                _growthShift( 1 ),
+                _lastChunkUsed( 0 ),
+                _lastChunkCapacity( 0 ),
+                _arenaBytes( 0 ) {
+    max_load_factor( maxLoadFactor );
+    growth_factor( growthFactor );
+    _rehash( _minTableSize );
+}
+
+template<typename VALUE, typename HashT>
+myhash_arena<VALUE, HashT>::~myhash_arena() {
+    delete [] _table;
+    for( size_t i = 0; i < _chunks.size(); ++i ) {
+        ::operator delete( _chunks[i] );
+    }
+}
+
+template<typename VALUE, typename HashT> void
+myhash_arena<VALUE, HashT>::max_load_factor( float f ) {
+    if( !(f > 0 && f < 1) ) {
+        throw std::invalid_argument( "Max load factor must be in (0, 1)." );
+    }
+    _maxLoadFactor = f;
+    _update_threshold();
+}
+
+template<typename VALUE, typename HashT> void
+myhash_arena<VALUE, HashT>::growth_factor( Size f ) {
+    if( f < 2 || (f & (f - 1)) ) {
+        throw std::invalid_argument( "Growth factor must be a power of two." );
+    }
+    for( _growthShift = 0; f >>= 1; ++_growthShift ) {}
+}
+
+template<typename VALUE, typename HashT> void
+myhash_arena<VALUE, HashT>::_update_threshold() {
+    _fillmentThreshold = (Size) (_maxLoadFactor*_tableSize);
+    // at least one vacant slot must remain to terminate probing
+    if( _fillmentThreshold >= _tableSize ) {
+        _fillmentThreshold = _tableSize - 1;
+    }
+    if( !_fillmentThreshold ) {
+        _fillmentThreshold = 1;
+    }
+}
+
+template<typename VALUE, typename HashT> void
+myhash_arena<VALUE, HashT>::reserve( Size n ) {
+    Size size = _tableSize;
+    while( (Size) (_maxLoadFactor*size) < n ) {
+        if( size > (std::numeric_limits<Size>::max() >> 2) ) {
+            throw std::length_error( "Hash table size limit exceeded." );
+        }
+        size <<= 1;
+    }
+    if( size != _tableSize ) {
+        _rehash( size );
+    }
+}
+
+template<typename VALUE, typename HashT> uint64_t
+myhash_arena<VALUE, HashT>::_intern( const char * data, uint32_t l ) {
+    if( _chunks.empty() || _lastChunkCapacity - _lastChunkUsed < l ) {
+        // keys longer than chunk get the chunk of their own
+        const size_t capacity = l > _chunkSize ? l : _chunkSize;
+        if( _chunks.size() > 0xffffffffULL ) {
+            throw std::length_error( "Key arena size limit exceeded." );
+        }
+        _chunks.reserve( _chunks.size() + 1 );
+        _chunks.push_back( static_cast<char *>( ::operator new( capacity ) ) );
+        _lastChunkUsed = 0;
+        _lastChunkCapacity = capacity;
+        _arenaBytes += capacity;
+    }
+    const uint64_t offset = (uint64_t(_chunks.size() - 1) << 32) | _lastChunkUsed;
+    memcpy( _chunks.back() + _lastChunkUsed, data, l );
+    _lastChunkUsed += l;
+    return offset;
+}
+
+template<typename VALUE, typename HashT> void
+myhash_arena<VALUE, HashT>::_rehash( Size newSize ) {
+    Slot * old = _table;
+    const Size oldSize = _tableSize;
+    _table = new Slot [newSize]();
+    _tableSize = newSize;
+    _update_threshold();
+    if( !old ) {
+        return;
+    }
+    for( Size i = 0; i < oldSize; ++i ) {
+        if( !old[i].hashValue ) {
+            continue;
+        }
+        // no equal keys, take the first vacant slot
+        Size place = _home( old[i].hashValue >> 1 );
+        while( _table[place].hashValue ) {
+            place = _next(place);
+        }
+        _table[place].key = old[i].key;
+        _table[place].hashValue = old[i].hashValue;
+        _table[place].value = std::move( old[i].value );
+    }
+    delete [] old;
+}
+
+template<typename VALUE, typename HashT>
+typename myhash_arena<VALUE, HashT>::iterator
+myhash_arena<VALUE, HashT>::begin() const {
+    iterator it = _iterator( _table );
+    if( !_table->hashValue ) { ++it; }
+    return it;
+}
+
+template<typename VALUE, typename HashT>
+typename myhash_arena<VALUE, HashT>::Slot *
+myhash_arena<VALUE, HashT>::_probe( const myhash_string_ref & r, HashValue hv,
+                                    Size & place ) const {
+    const HashValue stored = (hv << 1) | 0x1;
+    if( r.size <= inlineCapacity ) {
+        // compare with the inline image of the key at once
+        SlotKey k;
+        k.set_inline( r.data, r.size );
+        for( place = _home(hv); _table[place].hashValue; place = _next(place) ) {
+            const Slot & s = _table[place];
+            if( s.hashValue == stored
+             && s.key.words[0] == k.words[0] && s.key.words[1] == k.words[1] ) {
+                return _table + place;
+            }
+        }
+        return nullptr_C11;
+    }
+    for( place = _home(hv); _table[place].hashValue; place = _next(place) ) {
+        const Slot & s = _table[place];
+        if( s.hashValue == stored && !s.key.is_inline() && s.key.length() == r.size
+         && !memcmp( _arena_data( s.key.offset() ), r.data, r.size ) ) {
+            return _table + place;
+        }
+    }
+    return nullptr_C11;
+}
+
+template<typename VALUE, typename HashT>
+template<typename ... ArgsT>
+std::pair<typename myhash_arena<VALUE, HashT>::Slot *, bool>
+myhash_arena<VALUE, HashT>::_find_or_insert( const myhash_string_ref & r,
+                                             ArgsT && ... args ) {
+    const HashValue hv = _hash(r);
+    Size place;
+    Slot * s = _probe( r, hv, place );
+    if( s ) {
+        return std::make_pair( s, false );
+    }
+    if( r.size > std::numeric_limits<uint32_t>::max() ) {
+        throw std::length_error( "Key is too long." );
+    }
+    if( _nOccupiedEntries >= _fillmentThreshold ) {
+        if( _tableSize > (std::numeric_limits<Size>::max() >> (_growthShift + 1)) ) {
+            throw std::length_error( "Hash table size limit exceeded." );
+        }
+        _rehash( _tableSize << _growthShift );
+        // remembered slot is lost on growth
+        for( place = _home(hv); _table[place].hashValue; place = _next(place) ) {}
+    }
+    s = _table + place;
+    s->value = Value( std::forward<ArgsT>(args)... );
+    if( r.size <= inlineCapacity ) {
+        s->key.set_inline( r.data, r.size );
+    } else {
+        s->key.set_external( _intern( r.data, (uint32_t) r.size ), (uint32_t) r.size );
+    }
+    s->hashValue = (hv << 1) | 0x1;
+    ++_nOccupiedEntries;
+    return std::make_pair( s, true );
+}
+
+template<typename VALUE, typename HashT>
+const typename myhash_arena<VALUE, HashT>::Value &
+myhash_arena<VALUE, HashT>::at( const myhash_string_ref & r ) const {
+    const Slot * s = _find(r);
+    if( !s ) {
+        throw std::out_of_range( "Element not found." );
+    }
+    return s->value;
+}
+
+template<typename VALUE, typename HashT> void
+myhash_arena<VALUE, HashT>::erase( const const_iterator & it ) {
+    if( it.slot < _table || it.slot >= _table + _tableSize || !it.slot->hashValue ) {
+        throw std::out_of_range( "Invalid iterator provided." );
+    }
+    // Backward shift: the entry following the hole is moved into it unless
+    // its home slot lies between the hole and it (cyclically), i.e. unless
+    // it would become unreachable from its home.
+    const Size mask = _tableSize - 1;
+    Size hole = it.slot - _table;
+    for( Size place = _next(hole); _table[place].hashValue; place = _next(place) ) {
+        const Size home = _home( _table[place].hashValue >> 1 );
+        if( ((place - home) & mask) >= ((place - hole) & mask) ) {
+            _table[hole].key = _table[place].key;
+            _table[hole].hashValue = _table[place].hashValue;
+            _table[hole].value = std::move( _table[place].value );
+            hole = place;
+        }
+    }
+    _table[hole].hashValue = 0;
+    _table[hole].value = Value();
+    --_nOccupiedEntries;
+}
+
+# endif  // H_RDUS_MYHASH_ARENA_H
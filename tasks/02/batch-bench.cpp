@@ -0,0 +1,149 @@
+# include <string>
+# include <vector>
+# include <iostream>
+# include <random>
+# include <chrono>
+
+# include <cstdlib>
+# include <cstdio>
+# include <unistd.h>
+
+# include "rdus.hpp"
+# include "benchargs.hpp"
+
+//
+// Batched operations with software prefetching (find_batch(), insert_batch())
+// versus scalar find()/insert() loops on myhash<std::string, int> tables far
+// exceeding the last level cache, where every lookup misses twice: on the
+// slot and on the key's heap buffer (keys are longer than std::string's
+// inline buffer). By default number of keys is chosen so that the table is
+// >=10x L3 size. Queries are (ptr, len) views of random keys looked up with
+// heterogeneous lookup, so the query array itself is sequential.
+//
+// Usage:
+//  $ batch-bench [nKeys [keyLength [nQueries]]]
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static void
+random_tokens( std::vector<std::string> & dest, size_t n, size_t length,
+               std::mt19937 & rng ) {
+    dest.reserve( dest.size() + n );
+    for( size_t i = 0; i < n; ++i ) {
+        std::string tok( length, ' ' );
+        for( size_t j = 0; j < length; ++j ) {
+            tok[j] = 'a' + rng()%26;
+        }
+        dest.push_back( tok );
+    }
+}
+
+static double
+ns_per_op( Clock::time_point s, Clock::time_point e, size_t n ) {
+    return std::chrono::duration<double, std::nano>(e - s).count()/n;
+}
+
+template<typename TableT> bool
+bench_batch( const char * name,
+             const std::vector<std::string> & keys,
+             const std::vector<int> & values,
+             const std::vector<myhash_string_ref> & hitQueries,
+             const std::vector<myhash_string_ref> & missQueries ) {
+    double tIns[2];
+    {
+        TableT t;
+        Clock::time_point s = Clock::now();
+        for( size_t i = 0; i < keys.size(); ++i ) {
+            t.insert( keys[i], values[i] );
+        }
+        tIns[0] = ns_per_op( s, Clock::now(), keys.size() );
+    }
+    TableT t;
+    Clock::time_point s = Clock::now();
+    const size_t nInserted = t.insert_batch( keys.data(), values.data(), keys.size() );
+    tIns[1] = ns_per_op( s, Clock::now(), keys.size() );
+
+    size_t nHits[4] = { 0, 0, 0, 0 };
+    double tFind[4];
+    const std::vector<myhash_string_ref> * queries[2] = { &hitQueries, &missQueries };
+    std::vector<typename TableT::const_iterator> out( hitQueries.size(), t.end() );
+    for( int q = 0; q < 2; ++q ) {
+        const std::vector<myhash_string_ref> & qs = *queries[q];
+        s = Clock::now();
+        for( size_t i = 0; i < qs.size(); ++i ) {
+            nHits[2*q] += t.find( qs[i] ) != t.end();
+        }
+        tFind[2*q] = ns_per_op( s, Clock::now(), qs.size() );
+
+        s = Clock::now();
+        t.find_batch( qs.data(), qs.size(), out.data() );
+        for( size_t i = 0; i < qs.size(); ++i ) {
+            nHits[2*q + 1] += out[i] != t.end();
+        }
+        tFind[2*q + 1] = ns_per_op( s, Clock::now(), qs.size() );
+    }
+    if( nInserted != keys.size() || (size_t) t.size() != keys.size()
+     || nHits[0] != hitQueries.size() || nHits[1] != hitQueries.size()
+     || nHits[2] || nHits[3] ) {
+        std::cerr << "Integrity check failure: " << name << ", " << t.size()
+                  << " entries, hits: " << nHits[0] << ", " << nHits[1]
+                  << ", " << nHits[2] << ", " << nHits[3] << std::endl;
+        return false;
+    }
+    printf( "%-12s%8.1f%10.1f%10.1f%10.1f%10.1f%10.1f%11.1f\n", name,
+            t.allocated_bytes()/1048576., tIns[0], tIns[1],
+            tFind[0], tFind[1], tFind[2], tFind[3] );
+    return true;
+}
+
+int
+main( int argc, const char * argv[] ) {
+    long l3 = sysconf( _SC_LEVEL3_CACHE_SIZE );
+    if( l3 <= 0 ) {
+        l3 = 32 << 20;
+    }
+    // ~64 bytes per slot; a half of the power of two table size, so the
+    // table is not grown once more and keys take less memory
+    size_t defaultKeys = 1;
+    while( defaultKeys*64 < size_t(10*l3) ) defaultKeys <<= 1;
+    defaultKeys /= 2;
+    size_t nKeys = defaultKeys,
+           keyLength = 24,
+           nQueries = 4000000;
+    size_t * const args[] = { &nKeys, &keyLength, &nQueries };
+    if( !bench_count_args( argc, argv, args, "[nKeys [keyLength [nQueries]]]" ) ) {
+        return EXIT_FAILURE;
+    }
+    std::mt19937 rng(1337);
+    std::vector<std::string> keys, missKeys;
+    random_tokens( keys, nKeys, keyLength, rng );
+    // longer by one char, so never present
+    random_tokens( missKeys, nQueries < nKeys ? nQueries : nKeys, keyLength + 1, rng );
+    std::vector<int> values( nKeys );
+    std::vector<myhash_string_ref> hitQueries, missQueries;
+    for( size_t i = 0; i < nQueries; ++i ) {
+        const std::string & h = keys[rng()%nKeys],
+                          & m = missKeys[rng()%missKeys.size()];
+        hitQueries.push_back( myhash_string_ref( h.data(), h.size() ) );
+        missQueries.push_back( myhash_string_ref( m.data(), m.size() ) );
+    }
+    for( size_t i = 0; i < nKeys; ++i ) {
+        values[i] = (int) i;
+    }
+
+    printf( "# %zu keys of %zu bytes, %zu queries, L3 %.1f MB, ns/op\n"
+            "%-12s%8s%10s%10s%10s%10s%10s%11s\n", nKeys, keyLength, nQueries,
+            l3/1048576., "probing", "MB", "insert", "ins,batch",
+            "hit", "hit,batch", "miss", "miss,batch" );
+    typedef myhash<std::string, int> LinearHash;
+    typedef myhash< std::string, int
+                  , myhash_default_hash<std::string>
+                  , myhash_default_equals<std::string>
+                  , myhash_robin_hood_probing > RobinHoodHash;
+    if( !bench_batch<LinearHash>( "linear", keys, values, hitQueries, missQueries )
+     || !bench_batch<RobinHoodHash>( "Robin Hood", keys, values, hitQueries,
+                                     missQueries ) ) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
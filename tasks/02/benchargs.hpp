@@ -0,0 +1,44 @@
+# ifndef H_RDUS_BENCH_ARGS_H
+# define H_RDUS_BENCH_ARGS_H
+
+# include <iostream>
+
+# include <cstdlib>
+# include <cctype>
+
+//
+// Command line of the benchmarks: optional positional numeric arguments
+// (sizes, counts), each with the default value.
+
+/// Parses unsigned number (decimal, hex or octal, as strtoul() does).
+/// Returns false if the argument is not a number.
+inline bool
+bench_number_arg( const char * arg, size_t & n ) {
+    if( !isdigit( (unsigned char) *arg ) ) {
+        return false;
+    }
+    char * end;
+    n = strtoul( arg, &end, 0 );
+    return !*end;
+}
+
+/// Reads argv[1], argv[2], ... into *counts[0], *counts[1], ..., that hold
+/// the defaults. Prints usage (argv[0] followed by given arguments synopsis)
+/// and returns false if there are more arguments than counts, or if any of
+/// them is not a number or is zero.
+template<size_t N> bool
+bench_count_args( int argc, const char * argv[], size_t * const (&counts)[N],
+                  const char * synopsis ) {
+    bool ok = argc <= int(N) + 1;
+    for( int i = 1; ok && i < argc; ++i ) {
+        ok = bench_number_arg( argv[i], *counts[i - 1] ) && *counts[i - 1];
+    }
+    if( !ok ) {
+        std::cerr << "Usage:" << std::endl
+                  << "    $ " << argv[0] << " " << synopsis << std::endl
+                  ;
+    }
+    return ok;
+}
+
+# endif  // H_RDUS_BENCH_ARGS_H
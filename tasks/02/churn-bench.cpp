@@ -0,0 +1,134 @@
+# include <string>
+# include <vector>
+# include <iostream>
+# include <random>
+# include <chrono>
+
+# include <cstdlib>
+# include <cstdio>
+
+# include "rdus.hpp"
+# include "benchargs.hpp"
+
+//
+// Insert/erase churn: table is filled with nKeys keys, then each step erases
+// random present key and inserts a new one, so the number of live entries
+// stays constant. After each epoch of churn the lookup latency and mean
+// probe length for hits and misses are sampled, for linear probing with
+// tombstones and for Robin Hood probing with backward-shift deletion.
+//
+// Tombstones of linear probing count toward growth threshold: once it is
+// reached by mostly tombstones, the table is re-built at the same size, so
+// the churn is not limited. Each epoch replaces a half of the keys.
+//
+// Usage:
+//  $ churn-bench [nKeys [nEpochs]]
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static std::string
+random_token( std::mt19937 & rng, size_t length=15 ) {
+    std::string tok( length, ' ' );
+    for( size_t j = 0; j < length; ++j ) {
+        tok[j] = 'a' + rng()%26;
+    }
+    return tok;
+}
+
+struct Sample {
+    double hitNs, missNs, hitDepth, missDepth;
+};
+
+template<typename TableT> bool
+sample_lookups( TableT & t, const std::vector<std::string> & live,
+                std::mt19937 & rng, size_t nSamples, Sample & r ) {
+    std::vector<std::string> hits, misses;
+    for( size_t i = 0; i < nSamples; ++i ) {
+        hits.push_back( live[rng()%live.size()] );
+        misses.push_back( random_token( rng, 16 ) );  // never present
+    }
+    size_t nFound = 0, hitDepth = 0, missDepth = 0;
+    Clock::time_point s = Clock::now();
+    for( size_t i = 0; i < nSamples; ++i ) {
+        nFound += t.find( hits[i] ) != t.end();
+        hitDepth += t.latest_search_depth();
+    }
+    Clock::time_point e = Clock::now();
+    r.hitNs = std::chrono::duration<double, std::nano>(e - s).count()/nSamples;
+    s = Clock::now();
+    for( size_t i = 0; i < nSamples; ++i ) {
+        nFound += t.find( misses[i] ) != t.end();
+        missDepth += t.latest_search_depth();
+    }
+    e = Clock::now();
+    r.missNs = std::chrono::duration<double, std::nano>(e - s).count()/nSamples;
+    r.hitDepth = double(hitDepth)/nSamples;
+    r.missDepth = double(missDepth)/nSamples;
+    if( nFound != nSamples ) {
+        std::cerr << "Integrity check failure: " << nFound << " found instead of "
+                  << nSamples << std::endl;
+        return false;
+    }
+    return true;
+}
+
+template<typename TableT> bool
+churn( const char * name, size_t nKeys, size_t nEpochs ) {
+    std::mt19937 rng(1337);
+    TableT t;
+    std::vector<std::string> live;
+    for( size_t i = 0; i < nKeys; ++i ) {
+        live.push_back( random_token( rng ) );
+        t[live.back()] = (int) i;
+    }
+    const size_t nSamples = 100000,
+                 opsPerEpoch = nKeys/2;
+    printf( "# %s, %zu keys, %zu ops per epoch\n"
+            "%6s%10s%10s%10s%10s%10s%10s%8s\n", name, nKeys, opsPerEpoch,
+            "epoch", "hit,ns", "miss,ns", "hit,d", "miss,d", "slots",
+            "tombs", "MB" );
+    Sample smp;
+    for( size_t epoch = 0; epoch <= nEpochs; ++epoch ) {
+        if( !sample_lookups( t, live, rng, nSamples, smp ) ) {
+            return false;
+        }
+        printf( "%6zu%10.2f%10.2f%10.3f%10.3f%10u%10u%8.1f\n", epoch,
+                smp.hitNs, smp.missNs, smp.hitDepth, smp.missDepth,
+                t.table_size(), t.tombstones(), t.allocated_bytes()/1048576. );
+        if( epoch == nEpochs ) break;
+        for( size_t op = 0; op < opsPerEpoch; ++op ) {
+            size_t n = rng()%live.size();
+            t.erase( live[n] );
+            live[n] = random_token( rng );
+            t[live[n]] = (int) op;
+        }
+        if( (size_t) t.size() != nKeys ) {
+            std::cerr << "Integrity check failure: size " << t.size()
+                      << " != " << nKeys << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int
+main( int argc, const char * argv[] ) {
+    size_t nKeys = 1000000,
+           nEpochs = 10;
+    size_t * const args[] = { &nKeys, &nEpochs };
+    if( !bench_count_args( argc, argv, args, "[nKeys [nEpochs]]" ) ) {
+        return EXIT_FAILURE;
+    }
+
+    typedef myhash<std::string, int> LinearHash;
+    typedef myhash< std::string, int
+                  , myhash_default_hash<std::string>
+                  , myhash_default_equals<std::string>
+                  , myhash_robin_hood_probing > RobinHoodHash;
+
+    if( !churn<LinearHash>( "linear probing, tombstones", nKeys, nEpochs )
+     || !churn<RobinHoodHash>( "Robin Hood, backward shift", nKeys, nEpochs ) ) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
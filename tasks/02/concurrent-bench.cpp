@@ -0,0 +1,178 @@
+# include <string>
+# include <vector>
+# include <iostream>
+# include <random>
+# include <chrono>
+# include <thread>
+# include <mutex>
+# include <atomic>
+# include <unordered_map>
+
+# include <cstdlib>
+# include <cstdio>
+
+# include "concurrenthash.hpp"
+# include "benchargs.hpp"
+
+//
+// Multi-threaded throughput of sharded myhash_concurrent<std::string, int>
+// versus std::unordered_map guarded by single std::mutex, for 1..64 threads.
+// Table is pre-filled with nKeys keys; every thread then performs its share
+// of nOps operations on random keys:
+//  - read-mostly: 95% lookups of present keys, 5% assignments of them;
+//  - write-heavy: 50% lookups, 25% insertions and 25% erasures of keys from
+//    twice larger key set (so half of them are present at any time).
+// Integrity checks: every lookup of read-mostly hits, resulting size equals
+// initial one plus successful insertions minus successful erasures.
+//
+// Usage:
+//  $ g++ -std=c++11 -O2 -pthread concurrent-bench.cpp -o concurrent-bench
+//  $ concurrent-bench [nKeys [nOps [maxThreads]]]
+
+typedef std::chrono::high_resolution_clock Clock;
+
+/// Reference: std::unordered_map behind a mutex, with the same interface.
+class LockedMap {
+private:
+    mutable std::mutex _m;
+    std::unordered_map<std::string, int> _map;
+public:
+    bool find( const std::string & k, int & dest ) const {
+        std::lock_guard<std::mutex> g(_m);
+        std::unordered_map<std::string, int>::const_iterator it = _map.find(k);
+        if( it == _map.end() ) return false;
+        dest = it->second;
+        return true;
+    }
+    bool insert( const std::string & k, int v ) {
+        std::lock_guard<std::mutex> g(_m);
+        return _map.insert( std::make_pair( k, v ) ).second;
+    }
+    void insert_or_assign( const std::string & k, int v ) {
+        std::lock_guard<std::mutex> g(_m);
+        _map[k] = v;
+    }
+    bool erase( const std::string & k ) {
+        std::lock_guard<std::mutex> g(_m);
+        return _map.erase(k);
+    }
+    size_t size() const {
+        std::lock_guard<std::mutex> g(_m);
+        return _map.size();
+    }
+};
+
+typedef myhash_concurrent<std::string, int> ShardedHash;
+
+static void
+random_tokens( std::vector<std::string> & dest, size_t n, size_t length,
+               std::mt19937 & rng ) {
+    dest.reserve( dest.size() + n );
+    for( size_t i = 0; i < n; ++i ) {
+        std::string tok( length, ' ' );
+        for( size_t j = 0; j < length; ++j ) {
+            tok[j] = 'a' + rng()%26;
+        }
+        dest.push_back( tok );
+    }
+}
+
+struct Counters {
+    size_t nMisses, nInserted, nErased;
+};
+
+template<typename TableT> void
+read_mostly( TableT & t, const std::vector<std::string> & keys, size_t nKeys,
+             size_t nOps, unsigned seed, Counters & c ) {
+    std::mt19937 rng( seed );
+    int v;
+    for( size_t i = 0; i < nOps; ++i ) {
+        const size_t n = rng()%nKeys;
+        if( rng()%100 < 5 ) {
+            t.insert_or_assign( keys[n], (int) i );
+        } else if( !t.find( keys[n], v ) ) {
+            ++c.nMisses;
+        }
+    }
+}
+
+template<typename TableT> void
+write_heavy( TableT & t, const std::vector<std::string> & keys, size_t nKeys,
+             size_t nOps, unsigned seed, Counters & c ) {
+    std::mt19937 rng( seed );
+    int v;
+    for( size_t i = 0; i < nOps; ++i ) {
+        const size_t n = rng()%(2*nKeys);
+        switch( rng()%4 ) {
+            case 0 : c.nInserted += t.insert( keys[n], (int) i ); break;
+            case 1 : c.nErased += t.erase( keys[n] ); break;
+            default : c.nMisses += !t.find( keys[n], v );
+        };
+    }
+}
+
+template<typename TableT> bool
+bench( bool readMostly, const std::vector<std::string> & keys, size_t nKeys,
+       size_t nOps, unsigned nThreads, double & mops ) {
+    TableT t;
+    for( size_t i = 0; i < nKeys; ++i ) {
+        t.insert( keys[i], (int) i );
+    }
+    std::vector<Counters> counters( nThreads, Counters{0, 0, 0} );
+    std::vector<std::thread> threads;
+    Clock::time_point s = Clock::now();
+    for( unsigned i = 0; i < nThreads; ++i ) {
+        threads.push_back( std::thread( readMostly ? read_mostly<TableT>
+                                                   : write_heavy<TableT>,
+                                        std::ref(t), std::cref(keys), nKeys,
+                                        nOps/nThreads, 1337 + i,
+                                        std::ref(counters[i]) ) );
+    }
+    for( unsigned i = 0; i < nThreads; ++i ) {
+        threads[i].join();
+    }
+    Clock::time_point e = Clock::now();
+    mops = nOps/std::chrono::duration<double, std::micro>(e - s).count();
+    size_t nExpected = nKeys, nMisses = 0;
+    for( unsigned i = 0; i < nThreads; ++i ) {
+        nExpected += counters[i].nInserted;
+        nExpected -= counters[i].nErased;
+        nMisses += counters[i].nMisses;
+    }
+    if( t.size() != nExpected || (readMostly && nMisses) ) {
+        std::cerr << "Integrity check failure: " << t.size() << " entries instead of "
+                  << nExpected << ", " << nMisses << " misses." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int
+main( int argc, const char * argv[] ) {
+    size_t nKeys = 1000000,
+           nOps = 8000000,
+           maxThreads = 64;
+    size_t * const args[] = { &nKeys, &nOps, &maxThreads };
+    if( !bench_count_args( argc, argv, args, "[nKeys [nOps [maxThreads]]]" ) ) {
+        return EXIT_FAILURE;
+    }
+    std::mt19937 rng(1337);
+    std::vector<std::string> keys;
+    random_tokens( keys, 2*nKeys, 15, rng );
+
+    printf( "# %zu keys, %zu operations, %u hardware threads, Mops/s\n"
+            "%8s%14s%14s%14s%14s\n", nKeys, nOps,
+            std::thread::hardware_concurrency(), "threads",
+            "rd,mutex", "rd,sharded", "wr,mutex", "wr,sharded" );
+    for( unsigned n = 1; n <= maxThreads; n *= 2 ) {
+        double r[4];
+        if( !bench<LockedMap>( true, keys, nKeys, nOps, n, r[0] )
+         || !bench<ShardedHash>( true, keys, nKeys, nOps, n, r[1] )
+         || !bench<LockedMap>( false, keys, nKeys, nOps, n, r[2] )
+         || !bench<ShardedHash>( false, keys, nKeys, nOps, n, r[3] ) ) {
+            return EXIT_FAILURE;
+        }
+        printf( "%8u%14.2f%14.2f%14.2f%14.2f\n", n, r[0], r[1], r[2], r[3] );
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,246 @@
+# ifndef H_RDUS_MYHASH_CONCURRENT_H
+# define H_RDUS_MYHASH_CONCURRENT_H
+
+# include "rdus.hpp"
+
+# include <atomic>
+# include <thread>
+
+//
+// Thread-safe hash built of N independent myhash shards. The key is hashed
+// once; shard is chosen by the high bits of the (re-mixed) hash and the rest
+// is done by the shard's own table, so each shard grows on its own and
+// operations on different shards do not interfere at all.
+//
+// Every shard is guarded by a reader-writer lock: lookups of the same shard
+// run in parallel (they use myhash::_lookup(), which does not touch
+// latest_search_depth() or anything else), modifications are exclusive.
+// Optimistic (seqlock-like) reads are not used, since they would compare
+// keys (std::string etc) that may be concurrently destroyed.
+//
+// No iterators or references are given out: lookups copy the value (or call
+// a visitor with the lock held), since the entry may be moved by concurrent
+// insertion right after the lock is released.
+
+/// Reader-writer spin lock (C++11 has no std::shared_mutex). Writer takes
+/// the flag first, which stops new readers, then waits for the active ones
+/// to leave, so writers are not starved by the continuous reads. Spinning
+/// threads yield after a few attempts.
+class myhash_rw_lock {
+private:
+    static const uint32_t _writer = 0x80000000;
+    std::atomic<uint32_t> _state;  // writer flag | number of readers
+    static void _pause( unsigned n ) {
+        if( n > 16 ) std::this_thread::yield();
+    }
+public:
+    myhash_rw_lock() : _state(0) {}
+    myhash_rw_lock( const myhash_rw_lock & ) = delete;
+    myhash_rw_lock & operator=( const myhash_rw_lock & ) = delete;
+
+    void lock_shared() {
+        for( unsigned n = 0; ; ++n ) {
+            uint32_t s = _state.load( std::memory_order_relaxed );
+            if( !(s & _writer)
+             && _state.compare_exchange_weak( s, s + 1, std::memory_order_acquire,
+                                                        std::memory_order_relaxed ) ) {
+                return;
+            }
+            _pause(n);
+        }
+    }
+    void unlock_shared() { _state.fetch_sub( 1, std::memory_order_release ); }
+    void lock() {
+        for( unsigned n = 0; ; ++n ) {
+            uint32_t s = _state.load( std::memory_order_relaxed );
+            if( !(s & _writer)
+             && _state.compare_exchange_weak( s, s | _writer, std::memory_order_acquire,
+                                                              std::memory_order_relaxed ) ) {
+                break;
+            }
+            _pause(n);
+        }
+        for( unsigned n = 0; _state.load( std::memory_order_acquire ) != _writer; ++n ) {
+            _pause(n);
+        }
+    }
+    void unlock() { _state.store( 0, std::memory_order_release ); }
+};
+
+template<typename KEY, typename VALUE,
+         typename HashT=myhash_default_hash<KEY>,
+         typename EqualsT=myhash_default_equals<KEY>,
+         typename ProbingT=myhash_linear_probing,
+         typename GrowthT=myhash_rehash_at_once >
+class myhash_concurrent
+{
+public:
+    typedef myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT> Table;
+    typedef typename Table::Size Size;
+    typedef typename Table::HashValue HashValue;
+    typedef KEY Key;
+    typedef VALUE Value;
+private:
+    typedef typename Table::HashEntry HashEntry;
+    struct Shard {
+        mutable myhash_rw_lock lock;
+        Table table;
+        char padding[64];  // keeps locks of neighbouring shards apart
+    };
+    /// RAII guards for shard's lock.
+    struct SharedGuard {
+        myhash_rw_lock & l;
+        SharedGuard( myhash_rw_lock & l_ ) : l(l_) { l.lock_shared(); }
+        ~SharedGuard() { l.unlock_shared(); }
+    };
+    struct ExclusiveGuard {
+        myhash_rw_lock & l;
+        ExclusiveGuard( myhash_rw_lock & l_ ) : l(l_) { l.lock(); }
+        ~ExclusiveGuard() { l.unlock(); }
+    };
+
+    Shard * _shards;
+    Size _shardMask;
+
+    /// Shard index: high bits of the hash multiplied by golden ratio, so it
+    /// does not correlate with the low bits used for slot indexing.
+    Size _shard_of( HashValue hv ) const {
+        return ((hv*0x9e3779b9u) >> 16) & _shardMask;
+    }
+public:
+    /// Number of shards must be a power of two, not greater than 2^16.
+    myhash_concurrent( Size nShards=64, float maxLoadFactor=0.7 );
+    ~myhash_concurrent() { delete [] _shards; }
+    myhash_concurrent( const myhash_concurrent & ) = delete;
+    myhash_concurrent & operator=( const myhash_concurrent & ) = delete;
+
+    /// Copies the value of key k to dest; returns false if k is absent.
+    template<typename LookupT>
+    bool find( const LookupT & k, Value & dest ) const {
+        return visit( k, [&dest]( const Value & v ) { dest = v; } ); }
+    template<typename LookupT>
+    bool contains( const LookupT & k ) const {
+        return visit( k, []( const Value & ) {} ); }
+    /// Calls f(const Value &) with the shard's read lock held, if k is
+    /// present. Returns whether it is.
+    template<typename LookupT, typename FuncT>
+    bool visit( const LookupT & k, FuncT f ) const;
+
+    /// Inserts (k, v) if k is absent, returns true if it was.
+    bool insert( const Key & k, const Value & v );
+    /// Inserts (k, v) or assigns v to the present key.
+    void insert_or_assign( const Key & k, const Value & v );
+    /// Adds delta to the value of k (inserting default value, if absent),
+    /// returns the resulting value.
+    template<typename LookupT>
+    Value increment( const LookupT & k, const Value & delta=Value(1) );
+    /// Removes the key k, returns false if it was absent.
+    template<typename LookupT>
+    bool erase( const LookupT & k );
+
+    /// Number of entries; shards are counted one after another, so it is
+    /// not a snapshot while the table is modified.
+    size_t size() const;
+    Size shards() const { return _shardMask + 1; }
+};
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+myhash_concurrent<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::myhash_concurrent(
+                                                            Size nShards,
+                                                            float maxLoadFactor ) :
+                _shards( nullptr_C11 ),
+                _shardMask( nShards - 1 ) {
+    if( !nShards || (nShards & (nShards - 1)) || nShards > 0x10000 ) {
+        throw std::invalid_argument( "Number of shards must be a power of two"
+                                     " not greater than 65536." );
+    }
+    _shards = new Shard [nShards];
+    for( Size i = 0; i < nShards; ++i ) {
+        _shards[i].table.max_load_factor( maxLoadFactor );
+    }
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+template<typename LookupT, typename FuncT> bool
+myhash_concurrent<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::visit( const LookupT & k,
+                                                                         FuncT f ) const {
+    const HashValue hv = Table::_hash(k);
+    const Shard & s = _shards[_shard_of(hv)];
+    SharedGuard g( s.lock );
+    Size depth;
+    const HashEntry * e = s.table._lookup( k, hv, depth );
+    if( !e ) {
+        return false;
+    }
+    f( e->second );
+    return true;
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> bool
+myhash_concurrent<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::insert( const Key & k,
+                                                                          const Value & v ) {
+    const HashValue hv = Table::_hash(k);
+    Shard & s = _shards[_shard_of(hv)];
+    ExclusiveGuard g( s.lock );
+    return s.table._find_or_insert_hashed( hv, k, v ).second;
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> void
+myhash_concurrent<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::insert_or_assign(
+                                                            const Key & k,
+                                                            const Value & v ) {
+    const HashValue hv = Table::_hash(k);
+    Shard & s = _shards[_shard_of(hv)];
+    ExclusiveGuard g( s.lock );
+    std::pair<typename Table::iterator, bool> r
+                            = s.table._find_or_insert_hashed( hv, k, v );
+    if( !r.second ) {
+        r.first->second = v;
+    }
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+template<typename LookupT>
+typename myhash_concurrent<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::Value
+myhash_concurrent<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::increment(
+                                                            const LookupT & k,
+                                                            const Value & delta ) {
+    const HashValue hv = Table::_hash(k);
+    Shard & s = _shards[_shard_of(hv)];
+    ExclusiveGuard g( s.lock );
+    return s.table._find_or_insert_hashed( hv, k ).first->second += delta;
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+template<typename LookupT> bool
+myhash_concurrent<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::erase( const LookupT & k ) {
+    const HashValue hv = Table::_hash(k);
+    Shard & s = _shards[_shard_of(hv)];
+    ExclusiveGuard g( s.lock );
+    Size depth;
+    const HashEntry * e = s.table._lookup( k, hv, depth );
+    if( !e ) {
+        return false;
+    }
+    s.table.erase( typename Table::const_iterator( const_cast<HashEntry *>(e) ) );
+    return true;
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> size_t
+myhash_concurrent<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::size() const {
+    size_t n = 0;
+    for( Size i = 0; i <= _shardMask; ++i ) {
+        SharedGuard g( _shards[i].lock );
+        n += _shards[i].table.size();
+    }
+    return n;
+}
+
+# endif  // H_RDUS_MYHASH_CONCURRENT_H
@@ -0,0 +1,142 @@
+# include <string>
+# include <vector>
+# include <iostream>
+# include <random>
+# include <chrono>
+# include <unordered_map>
+
+# include <cstdlib>
+# include <cstdio>
+
+# include "frozenhash.hpp"
+# include "benchargs.hpp"
+
+//
+// Read-only lookup table of nKeys random words: live myhash<std::string,
+// int>, the frozen one made of it by freeze() (minimal perfect hash, n slots)
+// and std::unordered_map<std::string, int>. Reports build time (for the
+// frozen table -- freeze() time), hit and miss lookup latency (random order)
+// and memory of the table (not counting key's heap storage: keys are short
+// enough for std::string inline buffer by default; for std::unordered_map
+// estimated as 48 bytes per node, as allocated by glibc malloc, plus the
+// bucket array).
+//
+// Usage:
+//  $ frozen-bench [nKeys [keyLength [nQueries]]]
+
+typedef std::chrono::high_resolution_clock Clock;
+typedef myhash<std::string, int> Hash;
+typedef myhash_frozen<std::string, int> FrozenHash;
+typedef std::unordered_map<std::string, int> StdMap;
+
+static void
+random_tokens( std::vector<std::string> & dest, size_t n, size_t length,
+               std::mt19937 & rng ) {
+    dest.reserve( dest.size() + n );
+    for( size_t i = 0; i < n; ++i ) {
+        std::string tok( length, ' ' );
+        for( size_t j = 0; j < length; ++j ) {
+            tok[j] = 'a' + rng()%26;
+        }
+        dest.push_back( tok );
+    }
+}
+
+static double
+ns_per_op( Clock::time_point s, Clock::time_point e, size_t n ) {
+    return std::chrono::duration<double, std::nano>(e - s).count()/n;
+}
+
+template<typename TableT> size_t
+table_bytes( const TableT & t ) { return t.allocated_bytes(); }
+
+template<> size_t
+table_bytes<StdMap>( const StdMap & m ) {
+    return 48*m.size() + sizeof(void *)*m.bucket_count();
+}
+
+template<typename TableT> bool
+bench_lookup( const char * name, const TableT & t, double buildMs,
+              const std::vector<std::string> & hitQueries,
+              const std::vector<std::string> & missQueries, size_t nKeys,
+              long & sum ) {
+    sum = 0;
+    size_t nFound = 0;
+    Clock::time_point s = Clock::now();
+    for( size_t i = 0; i < hitQueries.size(); ++i ) {
+        typename TableT::const_iterator it = t.find( hitQueries[i] );
+        if( it != t.end() ) {
+            sum += it->second;
+            ++nFound;
+        }
+    }
+    const double hit = ns_per_op( s, Clock::now(), hitQueries.size() );
+    s = Clock::now();
+    for( size_t i = 0; i < missQueries.size(); ++i ) {
+        nFound += t.find( missQueries[i] ) != t.end();
+    }
+    const double miss = ns_per_op( s, Clock::now(), missQueries.size() );
+    if( (size_t) t.size() != nKeys || nFound != hitQueries.size() ) {
+        std::cerr << "Integrity check failure: " << name << ", " << t.size()
+                  << " entries, " << nFound << " found." << std::endl;
+        return false;
+    }
+    const size_t bytes = table_bytes( t );
+    printf( "%-16s%12.1f%10.1f%10.1f%10.1f%10.1f\n", name, buildMs, hit, miss,
+            bytes/1048576., double(bytes)/nKeys );
+    return true;
+}
+
+int
+main( int argc, const char * argv[] ) {
+    size_t nKeys = 4000000,
+           keyLength = 12,
+           nQueries = 4000000;
+    size_t * const args[] = { &nKeys, &keyLength, &nQueries };
+    if( !bench_count_args( argc, argv, args, "[nKeys [keyLength [nQueries]]]" ) ) {
+        return EXIT_FAILURE;
+    }
+    std::mt19937 rng(1337);
+    std::vector<std::string> keys, missQueries, hitQueries;
+    random_tokens( keys, nKeys, keyLength, rng );
+    // longer by one char, so never present
+    random_tokens( missQueries, nQueries, keyLength + 1, rng );
+    for( size_t i = 0; i < nQueries; ++i ) {
+        hitQueries.push_back( keys[rng()%nKeys] );
+    }
+
+    Hash h;
+    Clock::time_point s = Clock::now();
+    for( size_t i = 0; i < nKeys; ++i ) {
+        h[keys[i]] = (int) i;
+    }
+    const double hashMs = ns_per_op( s, Clock::now(), 1000000 );
+    s = Clock::now();
+    const FrozenHash f = h.freeze();
+    const double frozenMs = ns_per_op( s, Clock::now(), 1000000 );
+    StdMap m;
+    s = Clock::now();
+    for( size_t i = 0; i < nKeys; ++i ) {
+        m[keys[i]] = (int) i;
+    }
+    const double stdMs = ns_per_op( s, Clock::now(), 1000000 );
+    // duplicates of random words are counted once
+    const size_t nDistinct = h.size();
+
+    printf( "# %zu keys of %zu bytes, %zu queries, ns/op\n%-16s%12s%10s%10s%10s%10s\n",
+            nDistinct, keyLength, nQueries, "table", "build,ms", "hit", "miss",
+            "MB", "B/entry" );
+    long sums[3];
+    if( !bench_lookup( "myhash", h, hashMs, hitQueries, missQueries, nDistinct, sums[0] )
+     || !bench_lookup( "myhash_frozen", f, frozenMs, hitQueries, missQueries,
+                       nDistinct, sums[1] )
+     || !bench_lookup( "unordered_map", m, stdMs, hitQueries, missQueries,
+                       nDistinct, sums[2] ) ) {
+        return EXIT_FAILURE;
+    }
+    if( sums[0] != sums[1] || sums[1] != sums[2] ) {
+        std::cerr << "Integrity check failure: sums of found values differ." << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
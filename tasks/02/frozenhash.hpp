@@ -0,0 +1,320 @@
+# ifndef H_RDUS_MYHASH_FROZEN_H
+# define H_RDUS_MYHASH_FROZEN_H
+
+# include "rdus.hpp"
+
+# include <vector>
+# include <utility>
+# include <algorithm>
+
+//
+// Immutable hash table on minimal perfect hash function (hash-and-displace,
+// as in CHD and PTHash), built by myhash::freeze() for the tables that are
+// only queried once built. n keys take exactly n slots of key and value, no
+// vacant slots, flags or stored hashes.
+//
+// The key's seeded 64-bit hash h selects one of ~n/4 buckets (by its high
+// half). Every bucket has a "pilot" number, found at build time, such that
+// slot positions pos(h, pilot) of all the bucket's keys are distinct and
+// free. Lookup hashes the key, reads the pilot of its bucket and compares
+// the key at the computed position: one slot access and one key comparison,
+// both for present keys and for absent ones (which land on some slot and
+// fail the comparison).
+//
+// Build places the buckets largest first (while the table is still mostly
+// free), trying pilots 0, 1, 2, ... for each; the last singleton buckets
+// search for the few remaining free slots, so it takes O(n log n) hash
+// evaluations overall. If two keys of a bucket have equal 64-bit hash (no
+// pilot separates them) or the pilot is not found within the limit, the
+// build restarts with another seed.
+//
+// Memory: n slots plus 4-byte pilot per bucket (~1 byte per key).
+//
+// Interface follows myhash for lookups (find(), at(), operator[] const,
+// iterator with ->first/->second and ->key/->value); there is no
+// modification at all.
+
+/// Seeded 64-bit hash of the key for myhash_frozen: 32-bit hash of myhash
+/// would give pairs of colliding keys (that no pilot separates) already at
+/// ~10^5 keys. Integer keys are mixed by murmur3 64-bit finalizer that is a
+/// bijection, so distinct keys never collide.
+template<typename T>
+struct myhash_default_hash64 {
+    static uint64_t hash( const T & k, uint64_t seed ) {
+        return myhash_fmix64( uint64_t(k) ^ seed ); }
+};
+
+template<>
+struct myhash_default_hash64<std::string> {
+    static uint64_t hash( const std::string & k, uint64_t seed ) {
+        return wyhash64( (const uint8_t *) k.data(), k.size(), seed ); }
+    static uint64_t hash( const myhash_string_ref & r, uint64_t seed ) {
+        return wyhash64( (const uint8_t *) r.data, r.size, seed ); }
+};
+
+template<typename KEY, typename VALUE,
+         typename Hash64T=myhash_default_hash64<KEY>,
+         typename EqualsT=myhash_default_equals<KEY> >
+class myhash_frozen {
+public:
+    typedef uint32_t Size;
+    typedef KEY Key;
+    typedef VALUE Value;
+    typedef Hash64T Hash64;
+    typedef EqualsT Equals;
+    typedef myhash_frozen<Key, Value, Hash64, Equals> Self;
+
+    struct Slot {
+        Key key;
+        Value value;
+    };
+
+    /// Proxy returned by iterator dereference, ref members for spec
+    /// compat.
+    struct Reference {
+        const Key & first;
+        const Value & second;
+        const Key & key;
+        const Value & value;
+
+        Reference( const Slot & s ) :
+                    first(s.key), second(s.value), key(s.key), value(s.value) {}
+        /// Makes iterator's operator->() chain to the members.
+        Reference * operator->() { return this; }
+    };
+
+    /// All the slots are occupied, so iteration is plain array traversal.
+    struct iterator {
+        const Slot * slot;
+
+        iterator( const Slot * s ) : slot(s) {}
+
+        iterator & operator++() { ++slot; return *this; }
+        iterator operator++(int) { iterator it(*this); ++slot; return it; }
+        Reference operator->() const { return Reference( *slot ); }
+        Reference operator*() const { return Reference( *slot ); }
+
+        friend bool operator!= (const iterator & l,
+                                const iterator & r) { return l.slot != r.slot; }
+        friend bool operator== (const iterator & l,
+                                const iterator & r) { return ! (l != r); }
+    };
+    typedef iterator const_iterator;
+private:
+    std::vector<Slot> _slots;
+    std::vector<uint32_t> _pilots;  // one per bucket
+    uint64_t _seed;
+protected:
+    static const Size _bucketLoad = 4;  // average number of keys per bucket
+    /// Bucket of the key: high half of the hash scaled to bucket count.
+    Size _bucket( uint64_t h ) const {
+        return (Size) ((uint64_t(uint32_t(h >> 32))*_pilots.size()) >> 32); }
+    uint64_t _pilot_hash( uint64_t pilot ) const { return myhash_fmix64( pilot + _seed ); }
+    /// Slot position of the key for given (hashed) pilot: the hash is
+    /// displaced by the pilot, mixed and scaled to the table size.
+    static Size _position( uint64_t h, uint64_t pilotHash, Size n ) {
+        const uint64_t x = (h ^ pilotHash)*0x9e3779b97f4a7c15ULL;
+        return (Size) (((x >> 32)*n) >> 32);
+    }
+    /// Finds the pilots of all buckets for the current seed, writing final
+    /// positions of the keys. Returns false if the seed does not work.
+    bool _place( const std::vector<uint64_t> & hashes, std::vector<Size> & positions );
+    template<typename LookupT>
+    const Slot * _find( const LookupT & k ) const;
+public:
+    myhash_frozen() : _seed( 0 ) {}
+    /// Builds the table of given entries, that must have distinct keys
+    /// (std::invalid_argument is thrown otherwise).
+    explicit myhash_frozen( std::vector<Slot> && entries );
+
+    iterator begin() const { return iterator( _slots.data() ); }
+    iterator end() const { return iterator( _slots.data() + _slots.size() ); }
+
+    iterator find( const Key & k ) const {
+        const Slot * s = _find(k);
+        return s ? iterator( s ) : end(); }
+    iterator find( const myhash_string_ref & r ) const {
+        const Slot * s = _find(r);
+        return s ? iterator( s ) : end(); }
+    template<typename CharT> typename myhash_if_c_string<Key, CharT, iterator>::type
+    find( const CharT * s ) const { return find( myhash_string_ref(s) ); }
+
+    const Value & at( const Key & k ) const;
+    const Value & at( const myhash_string_ref & r ) const;
+    const Value & operator[]( const Key & k ) const { return at(k); }
+    const Value & operator[]( const myhash_string_ref & r ) const { return at(r); }
+
+    int size() const { return (int) _slots.size(); }
+    /// Number of slots, always equal to size().
+    Size table_size() const { return (Size) _slots.size(); }
+    Size bucket_count() const { return (Size) _pilots.size(); }
+    /// Bytes allocated for slots and pilots (not counting key's own heap
+    /// storage).
+    size_t allocated_bytes() const {
+        return sizeof(Slot)*_slots.size() + sizeof(uint32_t)*_pilots.size(); }
+};  // class myhash_frozen
+
+// Implementation
+////////////////
+
+template<typename KEY, typename VALUE, typename Hash64T, typename EqualsT>
+myhash_frozen<KEY, VALUE, Hash64T, EqualsT>::myhash_frozen( std::vector<Slot> && entries ) :
+                _slots( std::move(entries) ),
+                _seed( 0x9e3779b97f4a7c15ULL ) {
+    const Size n = (Size) _slots.size();
+    if( _slots.size() != n ) {
+        throw std::length_error( "Hash table size limit exceeded." );
+    }
+    if( !n ) {
+        return;
+    }
+    _pilots.resize( (n + _bucketLoad - 1)/_bucketLoad );
+    std::vector<uint64_t> hashes( n );
+    std::vector<Size> positions( n );
+    for( ;; _seed = myhash_fmix64( _seed + 1 ) ) {
+        for( Size i = 0; i < n; ++i ) {
+            hashes[i] = Hash64::hash( _slots[i].key, _seed );
+        }
+        if( _place( hashes, positions ) ) {
+            break;
+        }
+    }
+    // move every entry to its position, following permutation cycles
+    for( Size i = 0; i < n; ++i ) {
+        while( positions[i] != i ) {
+            const Size j = positions[i];
+            std::swap( _slots[i], _slots[j] );
+            positions[i] = positions[j];
+            positions[j] = j;
+        }
+    }
+}
+
+template<typename KEY, typename VALUE, typename Hash64T, typename EqualsT> bool
+myhash_frozen<KEY, VALUE, Hash64T, EqualsT>::_place( const std::vector<uint64_t> & hashes,
+                                                     std::vector<Size> & positions ) {
+    const Size n = (Size) hashes.size(),
+               nBuckets = (Size) _pilots.size();
+    // keys grouped by bucket (counting sort): bucket b has keys
+    // byBucket[start[b]..start[b + 1])
+    std::vector<Size> start( nBuckets + 1, 0 ), byBucket( n );
+    for( Size i = 0; i < n; ++i ) {
+        ++start[_bucket( hashes[i] ) + 1];
+    }
+    for( Size b = 0; b < nBuckets; ++b ) {
+        start[b + 1] += start[b];
+    }
+    {
+        std::vector<Size> fill( start.begin(), start.end() - 1 );
+        for( Size i = 0; i < n; ++i ) {
+            byBucket[fill[_bucket( hashes[i] )]++] = i;
+        }
+    }
+    std::vector<Size> order( nBuckets );
+    for( Size b = 0; b < nBuckets; ++b ) {
+        order[b] = b;
+    }
+    std::stable_sort( order.begin(), order.end(), [&start]( Size l, Size r ) {
+                return start[l + 1] - start[l] > start[r + 1] - start[r]; } );
+
+    std::vector<uint64_t> taken( (n + 63) >> 6, 0 );
+    std::vector<Size> bucketPositions;
+    // the last free slot is found in ~n attempts
+    const uint64_t maxPilot = std::min<uint64_t>( 0xffffffffULL, 64*uint64_t(n) + 1024 );
+    for( Size ob = 0; ob < nBuckets; ++ob ) {
+        const Size b = order[ob],
+                   * keys = byBucket.data() + start[b],
+                   size = start[b + 1] - start[b];
+        if( !size ) {
+            break;  // the rest are empty as well
+        }
+        for( Size i = 1; i < size; ++i ) {
+            for( Size j = 0; j < i; ++j ) {
+                if( hashes[keys[i]] != hashes[keys[j]] ) {
+                    continue;
+                }
+                if( Equals::equals( _slots[keys[i]].key, _slots[keys[j]].key ) ) {
+                    throw std::invalid_argument( "Keys of frozen table must be distinct." );
+                }
+                return false;
+            }
+        }
+        bucketPositions.resize( size );
+        uint64_t pilot = 0;
+        for( ; pilot <= maxPilot; ++pilot ) {
+            const uint64_t ph = _pilot_hash( pilot );
+            Size i = 0;
+            for( ; i < size; ++i ) {
+                const Size p = _position( hashes[keys[i]], ph, n );
+                if( taken[p >> 6] & (uint64_t(1) << (p & 63))
+                 || std::find( bucketPositions.begin(), bucketPositions.begin() + i, p )
+                        != bucketPositions.begin() + i ) {
+                    break;
+                }
+                bucketPositions[i] = p;
+            }
+            if( i == size ) {
+                break;
+            }
+        }
+        if( pilot > maxPilot ) {
+            return false;
+        }
+        _pilots[b] = (uint32_t) pilot;
+        for( Size i = 0; i < size; ++i ) {
+            const Size p = bucketPositions[i];
+            taken[p >> 6] |= uint64_t(1) << (p & 63);
+            positions[keys[i]] = p;
+        }
+    }
+    return true;
+}
+
+template<typename KEY, typename VALUE, typename Hash64T, typename EqualsT>
+template<typename LookupT>
+const typename myhash_frozen<KEY, VALUE, Hash64T, EqualsT>::Slot *
+myhash_frozen<KEY, VALUE, Hash64T, EqualsT>::_find( const LookupT & k ) const {
+    if( _slots.empty() ) {
+        return nullptr_C11;
+    }
+    const uint64_t h = Hash64::hash( k, _seed );
+    const Slot & s = _slots[_position( h, _pilot_hash( _pilots[_bucket(h)] ),
+                                       (Size) _slots.size() )];
+    return Equals::equals( s.key, k ) ? &s : nullptr_C11;
+}
+
+template<typename KEY, typename VALUE, typename Hash64T, typename EqualsT>
+const typename myhash_frozen<KEY, VALUE, Hash64T, EqualsT>::Value &
+myhash_frozen<KEY, VALUE, Hash64T, EqualsT>::at( const Key & k ) const {
+    const Slot * s = _find(k);
+    if( !s ) {
+        throw std::out_of_range( "Element not found." );
+    }
+    return s->value;
+}
+
+template<typename KEY, typename VALUE, typename Hash64T, typename EqualsT>
+const typename myhash_frozen<KEY, VALUE, Hash64T, EqualsT>::Value &
+myhash_frozen<KEY, VALUE, Hash64T, EqualsT>::at( const myhash_string_ref & r ) const {
+    const Slot * s = _find(r);
+    if( !s ) {
+        throw std::out_of_range( "Element not found." );
+    }
+    return s->value;
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+myhash_frozen<KEY, VALUE, myhash_default_hash64<KEY>, EqualsT>
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::freeze() const {
+    typedef myhash_frozen<Key, Value, myhash_default_hash64<Key>, Equals> Frozen;
+    std::vector<typename Frozen::Slot> entries;
+    entries.reserve( _nOccupiedEntries );
+    for_each( [&entries]( const Key & k, const Value & v ) {
+                typename Frozen::Slot s = { k, v };
+                entries.push_back( s );
+            } );
+    return Frozen( std::move(entries) );
+}
+
+# endif  // H_RDUS_MYHASH_FROZEN_H
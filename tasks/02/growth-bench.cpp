@@ -0,0 +1,90 @@
+# include <string>
+# include <vector>
+# include <iostream>
+# include <random>
+# include <chrono>
+
+# include <cstdlib>
+# include <cstdio>
+
+# include "rdus.hpp"
+
+//
+// Growth-heavy insertion into myhash<std::string, int> starting from the
+// empty table: every key goes through log2(n/8) table growths. Short keys
+// fit into std::string's inline buffer (SSO), long ones are heap-allocated,
+// so their copy costs an allocation while move does not. Keys are inserted
+// by copy (operator[](const KEY &)) and by move (operator[](KEY &&), keys are
+// prepared in advance and moved in), for linear and Robin Hood probing.
+//
+// Usage:
+//  $ growth-bench [nKeys]
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static void
+random_tokens( std::vector<std::string> & dest, size_t n, size_t length,
+               std::mt19937 & rng ) {
+    dest.reserve( dest.size() + n );
+    for( size_t i = 0; i < n; ++i ) {
+        std::string tok( length, ' ' );
+        for( size_t j = 0; j < length; ++j ) {
+            tok[j] = 'a' + rng()%26;
+        }
+        dest.push_back( tok );
+    }
+}
+
+template<typename TableT> bool
+bench_growth( std::vector<std::string> keys, bool byMove, double & nsPerKey ) {
+    TableT t;
+    const size_t n = keys.size();
+    Clock::time_point s = Clock::now();
+    if( byMove ) {
+        for( size_t i = 0; i < n; ++i ) {
+            t[std::move(keys[i])] = (int) i;
+        }
+    } else {
+        for( size_t i = 0; i < n; ++i ) {
+            t[keys[i]] = (int) i;
+        }
+    }
+    Clock::time_point e = Clock::now();
+    nsPerKey = std::chrono::duration<double, std::nano>(e - s).count()/n;
+    if( (size_t) t.size() != n ) {
+        std::cerr << "Integrity check failure: " << t.size() << " entries instead of "
+                  << n << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int
+main( int argc, const char * argv[] ) {
+    const size_t nKeys = argc > 1 ? strtoul( argv[1], NULL, 0 ) : 1000000;
+    const size_t lengths[] = { 12, 48 };
+
+    typedef myhash<std::string, int> LinearHash;
+    typedef myhash< std::string, int
+                  , myhash_default_hash<std::string>
+                  , myhash_default_equals<std::string>
+                  , myhash_robin_hood_probing > RobinHoodHash;
+
+    printf( "# %zu keys inserted into empty table, ns/insertion\n"
+            "%10s%14s%14s%14s%14s\n", nKeys, "key len",
+            "linear,copy", "linear,move", "RH,copy", "RH,move" );
+    for( size_t l = 0; l < sizeof(lengths)/sizeof(*lengths); ++l ) {
+        std::mt19937 rng(1337);
+        std::vector<std::string> keys;
+        random_tokens( keys, nKeys, lengths[l], rng );
+        double t[4];
+        if( !bench_growth<LinearHash>( keys, false, t[0] )
+         || !bench_growth<LinearHash>( keys, true, t[1] )
+         || !bench_growth<RobinHoodHash>( keys, false, t[2] )
+         || !bench_growth<RobinHoodHash>( keys, true, t[3] ) ) {
+            return EXIT_FAILURE;
+        }
+        printf( "%10zu%14.2f%14.2f%14.2f%14.2f\n", lengths[l], t[0], t[1], t[2], t[3] );
+    }
+    return EXIT_SUCCESS;
+}
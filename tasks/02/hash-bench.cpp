@@ -0,0 +1,225 @@
+# include <string>
+# include <vector>
+# include <fstream>
+# include <iostream>
+# include <random>
+# include <chrono>
+
+# include <cstdlib>
+# include <cstdio>
+# include <cctype>
+
+# if defined(__x86_64__) || defined(__i386__)
+# include <x86intrin.h>
+# endif
+
+# include "rdus.hpp"
+
+//
+// Hash functions benchmark suite:
+//  1. throughput of each byte sequence hash function (bytes per CPU cycle,
+//     bytes per ns where TSC is not available) over key length buckets;
+//  2. probe length distribution of myhash<std::string, int> built on the
+//     words read from given text files, for lookups of present (hits) and
+//     absent (misses) keys;
+//  3. if built with -DMYHASH_COLLECT_STATS, table statistics for every hash
+//     function and max load factor of 0.5, 0.7 and 0.9, as JSON array.
+//
+// Usage:
+//  $ hash-bench [words-file-1 [words-file-2 ...]]
+// With no files given, reads ../../assets/00/input-long.txt
+
+typedef myhash_runtime_hash<std::string> RuntimeHash;
+typedef myhash<std::string, int, RuntimeHash> StrHash;
+
+struct NamedHash {
+    const char * name;
+    RuntimeHash::HashFunction f;
+};
+
+static const NamedHash gHashes[] = {
+    { "adler32", adler32 },
+    { "djb2",    djb2 },
+    { "sdbm",    sdbm },
+    { "wyhash",  wyhash },
+};
+static const size_t gNHashes = sizeof(gHashes)/sizeof(*gHashes);
+
+# if defined(__x86_64__) || defined(__i386__)
+static uint64_t ticks() { return __rdtsc(); }
+static const char gTickUnits[] = "bytes/cycle";
+# else
+static uint64_t ticks() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+static const char gTickUnits[] = "bytes/ns";
+# endif
+
+static void
+throughput_suite() {
+    const size_t buckets[][2] = { {1, 4}, {5, 8}, {9, 16}, {17, 32},
+                                  {33, 64}, {65, 256}, {257, 1024} };
+    const size_t nBuckets = sizeof(buckets)/sizeof(*buckets),
+                 bytesPerBucket = 1 << 20;
+    std::mt19937 rng(1337);
+
+    printf( "# Throughput, %s\n%-12s", gTickUnits, "length" );
+    for( size_t i = 0; i < gNHashes; ++i ) {
+        printf( "%10s", gHashes[i].name );
+    }
+    printf( "\n" );
+
+    for( size_t b = 0; b < nBuckets; ++b ) {
+        std::uniform_int_distribution<size_t> lenD( buckets[b][0], buckets[b][1] );
+        std::vector<uint8_t> blob;
+        std::vector<std::pair<size_t, uint32_t> > keys;
+        while( blob.size() < bytesPerBucket ) {
+            size_t l = lenD(rng);
+            keys.push_back( std::make_pair( blob.size(), (uint32_t) l ) );
+            for( size_t i = 0; i < l; ++i ) {
+                blob.push_back( 'a' + rng()%26 );
+            }
+        }
+        char label[32];
+        snprintf( label, sizeof(label), "%zu-%zu", buckets[b][0], buckets[b][1] );
+        printf( "%-12s", label );
+        for( size_t h = 0; h < gNHashes; ++h ) {
+            const size_t nRepeats = 8;
+            volatile uint32_t sink = 0;
+            uint64_t t0 = ticks();
+            for( size_t r = 0; r < nRepeats; ++r ) {
+                for( size_t k = 0; k < keys.size(); ++k ) {
+                    sink = sink + gHashes[h].f( blob.data() + keys[k].first,
+                                                keys[k].second );
+                }
+            }
+            uint64_t t1 = ticks();
+            printf( "%10.3f", double(blob.size()*nRepeats)/(t1 - t0) );
+        }
+        printf( "\n" );
+    }
+}
+
+static void
+read_words( const char * path, std::vector<std::string> & words ) {
+    std::ifstream f( path );
+    if( !f ) {
+        std::cerr << "Warning: unable to open \"" << path << "\"." << std::endl;
+        return;
+    }
+    std::string w;
+    for( char c; f.get(c); ) {
+        if( isalpha( (unsigned char) c ) ) {
+            w += (char) tolower( (unsigned char) c );
+        } else if( !w.empty() ) {
+            words.push_back( w );
+            w.clear();
+        }
+    }
+    if( !w.empty() ) {
+        words.push_back( w );
+    }
+}
+
+struct DepthHistogram {
+    static const size_t nBins = 7;
+    size_t bins[nBins], n, sum, max;
+
+    DepthHistogram() : n(0), sum(0), max(0) {
+        for( size_t i = 0; i < nBins; ++i ) bins[i] = 0;
+    }
+    void account( size_t d ) {
+        // 0, 1, 2, 3, 4-7, 8-15, 16+
+        size_t bin = d < 4 ? d : (d < 8 ? 4 : (d < 16 ? 5 : 6));
+        ++bins[bin];
+        ++n;
+        sum += d;
+        if( d > max ) max = d;
+    }
+    void print( const char * name, const char * kind ) const {
+        printf( "%-8s %-6s", name, kind );
+        for( size_t i = 0; i < nBins; ++i ) {
+            printf( "%8.2f%%", n ? 100.*bins[i]/n : 0. );
+        }
+        printf( "%8.3f%6zu\n", n ? double(sum)/n : 0., max );
+    }
+};
+
+static void
+probe_length_suite( const std::vector<std::string> & words ) {
+    printf( "# Probe length, %zu words\n%-15s%9s%9s%9s%9s%9s%9s%9s%8s%6s\n",
+            words.size(), "hash", "0", "1", "2", "3", "4-7", "8-15", "16+",
+            "mean", "max" );
+    for( size_t h = 0; h < gNHashes; ++h ) {
+        RuntimeHash::set_function( gHashes[h].f );
+        StrHash table;
+        for( size_t i = 0; i < words.size(); ++i ) {
+            ++table[words[i]];
+        }
+        DepthHistogram hits, misses;
+        for( StrHash::iterator it = table.begin(); it != table.end(); ++it ) {
+            std::string k = it->first;
+            if( table.find(k) == table.end() ) {
+                std::cerr << "Integrity check failure: \"" << k
+                          << "\" not found." << std::endl;
+                exit( EXIT_FAILURE );
+            }
+            hits.account( table.latest_search_depth() );
+            k += '#';  // never produced by read_words()
+            table.find(k);
+            misses.account( table.latest_search_depth() );
+        }
+        hits.print( gHashes[h].name, "hit" );
+        misses.print( gHashes[h].name, "miss" );
+    }
+}
+
+# ifdef MYHASH_COLLECT_STATS
+static void
+stats_suite( const std::vector<std::string> & words ) {
+    const float loads[] = { 0.5, 0.7, 0.9 };
+    printf( "# Table statistics, JSON\n[" );
+    for( size_t h = 0; h < gNHashes; ++h ) {
+        RuntimeHash::set_function( gHashes[h].f );
+        for( size_t l = 0; l < sizeof(loads)/sizeof(*loads); ++l ) {
+            StrHash table( loads[l] );
+            for( size_t i = 0; i < words.size(); ++i ) {
+                ++table[words[i]];
+            }
+            for( size_t i = 0; i < words.size(); ++i ) {
+                table.find( words[i] );
+                table.find( words[i] + '#' );
+            }
+            printf( "%s\n{\"hash\": \"%s\", \"table\": ", h || l ? "," : "",
+                    gHashes[h].name );
+            table.dump_stats_json( stdout );
+            printf( "}" );
+        }
+    }
+    printf( "\n]\n" );
+}
+# endif
+
+int
+main( int argc, const char * argv[] ) {
+    std::vector<std::string> words;
+    if( argc > 1 ) {
+        for( int i = 1; i < argc; ++i ) {
+            read_words( argv[i], words );
+        }
+    } else {
+        read_words( "../../assets/00/input-long.txt", words );
+    }
+
+    throughput_suite();
+    if( words.empty() ) {
+        std::cerr << "No words read, probe length suite skipped." << std::endl;
+        return EXIT_SUCCESS;
+    }
+    probe_length_suite( words );
+    # ifdef MYHASH_COLLECT_STATS
+    stats_suite( words );
+    # endif
+    return EXIT_SUCCESS;
+}
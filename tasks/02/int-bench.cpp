@@ -0,0 +1,135 @@
+# include <vector>
+# include <iostream>
+# include <random>
+# include <chrono>
+# include <unordered_map>
+# include <algorithm>
+
+# include <cstdlib>
+# include <cstdio>
+
+# include "inthash.hpp"
+# include "benchargs.hpp"
+
+//
+// Integer-keyed lookup table: myhash_int<uint64_t, uint64_t> (sentinel key,
+// 16-byte slots) and myhash<uint64_t, uint64_t> (integer key hash
+// specialization, generic 40-byte HashEntry) versus
+// std::unordered_map<uint64_t, uint64_t>. Keys are either random 64-bit
+// numbers or sequential ids; insertion, hit and miss lookups (random order)
+// are timed, memory is the table size (for std::unordered_map estimated as
+// 32 bytes per node plus the bucket array, as allocated by glibc malloc).
+//
+// Usage:
+//  $ int-bench [nKeys [nQueries]]
+
+typedef std::chrono::high_resolution_clock Clock;
+typedef std::unordered_map<uint64_t, uint64_t> StdMap;
+
+static double
+ns_per_op( Clock::time_point s, Clock::time_point e, size_t n ) {
+    return std::chrono::duration<double, std::nano>(e - s).count()/n;
+}
+
+template<typename TableT> size_t
+table_bytes( const TableT & t ) { return t.allocated_bytes(); }
+
+template<> size_t
+table_bytes<StdMap>( const StdMap & m ) {
+    return 32*m.size() + sizeof(void *)*m.bucket_count();
+}
+
+template<typename TableT> bool
+bench_int( const char * name, const std::vector<uint64_t> & keys,
+           const std::vector<uint64_t> & hitQueries,
+           const std::vector<uint64_t> & missQueries ) {
+    TableT t;
+    Clock::time_point s = Clock::now();
+    for( size_t i = 0; i < keys.size(); ++i ) {
+        t[keys[i]] = keys[i] ^ 0x5555;
+    }
+    const double ins = ns_per_op( s, Clock::now(), keys.size() );
+
+    uint64_t sum = 0;
+    size_t nFound = 0;
+    s = Clock::now();
+    for( size_t i = 0; i < hitQueries.size(); ++i ) {
+        typename TableT::const_iterator it = t.find( hitQueries[i] );
+        if( it != t.end() ) {
+            sum += it->second;
+            ++nFound;
+        }
+    }
+    const double hit = ns_per_op( s, Clock::now(), hitQueries.size() );
+    s = Clock::now();
+    for( size_t i = 0; i < missQueries.size(); ++i ) {
+        nFound += t.find( missQueries[i] ) != t.end();
+    }
+    const double miss = ns_per_op( s, Clock::now(), missQueries.size() );
+
+    uint64_t expected = 0;
+    for( size_t i = 0; i < hitQueries.size(); ++i ) {
+        expected += hitQueries[i] ^ 0x5555;
+    }
+    if( (size_t) t.size() != keys.size() || nFound != hitQueries.size()
+     || sum != expected ) {
+        std::cerr << "Integrity check failure: " << name << ", " << t.size()
+                  << " entries, " << nFound << " found." << std::endl;
+        return false;
+    }
+    const size_t bytes = table_bytes( t );
+    printf( "%-16s%10.1f%10.1f%10.1f%10.1f%10.1f\n", name, ins, hit, miss,
+            bytes/1048576., double(bytes)/keys.size() );
+    return true;
+}
+
+static bool
+bench_keys( const char * name, const std::vector<uint64_t> & keys,
+            const std::vector<uint64_t> & missKeys, size_t nQueries,
+            std::mt19937_64 & rng ) {
+    std::vector<uint64_t> hitQueries, missQueries;
+    for( size_t i = 0; i < nQueries; ++i ) {
+        hitQueries.push_back( keys[rng()%keys.size()] );
+        missQueries.push_back( missKeys[rng()%missKeys.size()] );
+    }
+    printf( "# %s keys, ns/op\n%-16s%10s%10s%10s%10s%10s\n", name, "table",
+            "insert", "hit", "miss", "MB", "B/entry" );
+    return bench_int< myhash_int<uint64_t, uint64_t> >( "myhash_int", keys,
+                                                        hitQueries, missQueries )
+        && bench_int< myhash<uint64_t, uint64_t> >( "myhash", keys,
+                                                    hitQueries, missQueries )
+        && bench_int< StdMap >( "unordered_map", keys, hitQueries, missQueries );
+}
+
+int
+main( int argc, const char * argv[] ) {
+    size_t nKeys = 4000000,
+           nQueries = 4000000;
+    size_t * const args[] = { &nKeys, &nQueries };
+    if( !bench_count_args( argc, argv, args, "[nKeys [nQueries]]" ) ) {
+        return EXIT_FAILURE;
+    }
+    std::mt19937_64 rng(1337);
+    // random keys are odd, misses are even
+    std::vector<uint64_t> keys, missKeys;
+    for( size_t i = 0; i < nKeys; ++i ) {
+        keys.push_back( rng() | 1 );
+        missKeys.push_back( rng() & ~uint64_t(1) );
+    }
+    std::sort( keys.begin(), keys.end() );
+    keys.erase( std::unique( keys.begin(), keys.end() ), keys.end() );
+    std::shuffle( keys.begin(), keys.end(), rng );
+    if( !bench_keys( "random 64-bit", keys, missKeys, nQueries, rng ) ) {
+        return EXIT_FAILURE;
+    }
+    // ids 0..nKeys-1 inserted in order, misses are past them
+    for( size_t i = 0; i < nKeys; ++i ) {
+        keys[i] = i;
+        missKeys[i] = nKeys + i;
+    }
+    keys.resize( nKeys );
+    if( !bench_keys( "sequential", keys, missKeys, nQueries, rng ) ) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,357 @@
+# ifndef H_RDUS_MYHASH_INT_H
+# define H_RDUS_MYHASH_INT_H
+
+# include "rdus.hpp"
+
+# include <limits>
+# include <utility>
+
+//
+// Open addressing hash for integer keys. The slot is just the key and the
+// value (16 bytes for 64-bit key and value, cf. 40 of myhash::HashEntry):
+// no stored hash (re-hashing integer is cheaper than loading it), no flags
+// and no reference members. Vacant slots are marked by the reserved
+// "empty key" value (std::numeric_limits<Key>::max() by default); the entry
+// having that very key is kept in the extra slot past the table end, so the
+// whole key domain is still usable.
+//
+// Probing is linear and erasure is backward-shift (the following entries of
+// the probe chain are moved back into the freed slot), so the table never
+// holds tombstones and no second reserved key is needed. Mind, that erasure
+// moves entries, so erasing while iterating may skip entries.
+//
+// Keys are compared with ==; values must be default-constructible (vacant
+// slots hold value-initialized ones) and move-assignable.
+//
+// Interface follows myhash (operator[], find(), insert(), erase(),
+// iterator with ->first/->second and ->key/->value).
+
+template<typename KEY, typename VALUE,
+         typename HashT=myhash_default_hash<KEY> >
+class myhash_int {
+public:
+    typedef uint32_t Size;
+    typedef uint32_t HashValue;
+    typedef KEY Key;
+    typedef VALUE Value;
+    typedef HashT Hash;
+    typedef myhash_int<Key, Value, Hash> Self;
+
+    struct Slot {
+        Key key;
+        Value value;
+    };
+
+    /// Proxy returned by iterator dereference, ref members for spec
+    /// compat.
+    struct Reference {
+        const Key & first;
+        Value & second;
+        const Key & key;
+        Value & value;
+
+        Reference( Slot & s ) :
+                    first(s.key), second(s.value), key(s.key), value(s.value) {}
+        /// Makes iterator's operator->() chain to the members.
+        Reference * operator->() { return this; }
+    };
+
+    struct iterator {
+        Slot * slot;
+        const Slot * tableEnd;  // the extra slot
+        Key emptyKey;
+        bool hasEmptyKeyEntry;
+
+        iterator( Slot * s, const Slot * tEnd, Key e, bool has ) :
+                    slot(s), tableEnd(tEnd), emptyKey(e), hasEmptyKeyEntry(has) {}
+
+        /// Moves to the next occupied slot (or to the end).
+        iterator & operator++() {
+            do { ++slot; } while( slot < tableEnd && slot->key == emptyKey );
+            if( slot == tableEnd && !hasEmptyKeyEntry ) {
+                ++slot;
+            }
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator it(*this);
+            ++(*this);
+            return it;
+        }
+        Reference operator->() const { return Reference( *slot ); }
+        Reference operator*() const { return Reference( *slot ); }
+
+        friend bool operator!= (const iterator & l,
+                                const iterator & r) { return l.slot != r.slot; }
+        friend bool operator== (const iterator & l,
+                                const iterator & r) { return ! (l != r); }
+    };
+    typedef iterator const_iterator;
+private:
+    Slot * _table;  // _tableSize + 1 slots
+    Size _tableSize,  // always a power of two
+         _fillmentThreshold,
+         _nOccupiedEntries  // in the table, not counting the extra slot
+         ;
+    Key _emptyKey;
+    bool _hasEmptyKeyEntry;
+    float _maxLoadFactor;
+    uint8_t _growthShift;  // log2 of growth factor
+protected:
+    static const Size _minTableSize = 8;
+    Size _home( const Key & k ) const { return Hash::hash(k) & (_tableSize - 1); }
+    Size _next( Size place ) const { return (place + 1) & (_tableSize - 1); }
+    iterator _iterator( Slot * s ) const {
+        return iterator( s, _table + _tableSize, _emptyKey, _hasEmptyKeyEntry ); }
+    /// Slot of the key (extra one for the empty key), or null.
+    Slot * _find( const Key & k ) const;
+    /// Single-probe lookup with insertion of value constructed from args
+    /// on miss. Returns the slot and insertion flag.
+    template<typename ... ArgsT>
+    std::pair<Slot *, bool> _find_or_insert( const Key & k, ArgsT && ... args );
+    void _update_threshold();
+    /// Re-builds the table of given size (power of two).
+    void _rehash( Size newSize );
+public:
+    myhash_int( float maxLoadFactor=0.7, Size growthFactor=2,
+                Key emptyKey=std::numeric_limits<Key>::max() );
+    ~myhash_int() { delete [] _table; }
+
+    myhash_int( const Self & ) = delete;
+    Self & operator=( const Self & ) = delete;
+
+    Value & operator[]( const Key & k ) { return at(k); }
+    const Value & operator[]( const Key & k ) const { return at(k); }
+
+    Value & at( const Key & k ) { return _find_or_insert( k ).first->value; }
+    const Value & at( const Key & k ) const;
+
+    /// Inserts (k, v) if k is absent. Returns iterator to the element with
+    /// key k and true if it was inserted.
+    std::pair<iterator, bool> insert( const Key & k, const Value & v ) {
+        std::pair<Slot *, bool> r = _find_or_insert( k, v );
+        return std::make_pair( _iterator( r.first ), r.second ); }
+    /// Adds delta to the value of key k (inserting default value, if
+    /// absent). Returns reference to the updated value.
+    Value & increment( const Key & k, const Value & delta=Value(1) ) {
+        return _find_or_insert( k ).first->value += delta; }
+
+    iterator begin() const;
+    iterator end() const { return _iterator( _table + _tableSize + 1 ); }
+
+    iterator find( const Key & k ) const {
+        Slot * s = _find(k);
+        return s ? _iterator( s ) : end(); }
+
+    void erase( const Key & k ) { Slot * s = _find(k); if( s ) erase( _iterator(s) ); }
+    void erase( const const_iterator & it );
+
+    int size() const { return (int) (_nOccupiedEntries + _hasEmptyKeyEntry); }
+    Size table_size() const { return _tableSize; }
+    /// Reserved key value marking vacant slots.
+    Key empty_key() const { return _emptyKey; }
+    /// Bytes allocated for the table (not counting value's own heap storage).
+    size_t allocated_bytes() const { return sizeof(Slot)*(size_t(_tableSize) + 1); }
+    /// Makes room for n entries to be held without growth. Does not shrink.
+    void reserve( Size n );
+
+    float load_factor() const { return float(_nOccupiedEntries)/_tableSize; }
+    float max_load_factor() const { return _maxLoadFactor; }
+    /// Sets load factor (0, 1) that triggers growth. Does not shrink table.
+    void max_load_factor( float f );
+    Size growth_factor() const { return Size(1) << _growthShift; }
+    /// Sets table growth factor, must be a power of two >= 2.
+    void growth_factor( Size f );
+};  // class myhash_int
+
+// Implementation
+////////////////
+
+template<typename KEY, typename VALUE, typename HashT>
+myhash_int<KEY, VALUE, HashT>::myhash_int( float maxLoadFactor,
+                                           Size growthFactor,
+                                           Key emptyKey ) :
+                _table( nullptr_C11 ),
+                _tableSize( _minTableSize ),
+                _fillmentThreshold( 0 ),
+                _nOccupiedEntries( 0 ),
+                _emptyKey( emptyKey ),
+                _hasEmptyKeyEntry( false ),
+                _maxLoadFactor( 0.7 ),
+                _growthShift( 1 ) {
+    max_load_factor( maxLoadFactor );
+    growth_factor( growthFactor );
+    _rehash( _minTableSize );
+}
+
+template<typename KEY, typename VALUE, typename HashT> void
+myhash_int<KEY, VALUE, HashT>::max_load_factor( float f ) {
+    if( !(f > 0 && f < 1) ) {
+        throw std::invalid_argument( "Max load factor must be in (0, 1)." );
+    }
+    _maxLoadFactor = f;
+    _update_threshold();
+}
+
+template<typename KEY, typename VALUE, typename HashT> void
+myhash_int<KEY, VALUE, HashT>::growth_factor( Size f ) {
+    if( f < 2 || (f & (f - 1)) ) {
+        throw std::invalid_argument( "Growth factor must be a power of two." );
+    }
+    for( _growthShift = 0; f >>= 1; ++_growthShift ) {}
+}
+
+template<typename KEY, typename VALUE, typename HashT> void
+myhash_int<KEY, VALUE, HashT>::_update_threshold() {
+    _fillmentThreshold = (Size) (_maxLoadFactor*_tableSize);
+    // at least one vacant slot must remain to terminate probing
+    if( _fillmentThreshold >= _tableSize ) {
+        _fillmentThreshold = _tableSize - 1;
+    }
+    if( !_fillmentThreshold ) {
+        _fillmentThreshold = 1;
+    }
+}
+
+template<typename KEY, typename VALUE, typename HashT> void
+myhash_int<KEY, VALUE, HashT>::reserve( Size n ) {
+    Size size = _tableSize;
+    while( (Size) (_maxLoadFactor*size) < n ) {
+        if( size > (std::numeric_limits<Size>::max() >> 2) ) {
+            throw std::length_error( "Hash table size limit exceeded." );
+        }
+        size <<= 1;
+    }
+    if( size != _tableSize ) {
+        _rehash( size );
+    }
+}
+
+template<typename KEY, typename VALUE, typename HashT> void
+myhash_int<KEY, VALUE, HashT>::_rehash( Size newSize ) {
+    Slot * old = _table;
+    const Size oldSize = _tableSize;
+    _table = new Slot [newSize + 1]();
+    _tableSize = newSize;
+    _update_threshold();
+    for( Size i = 0; i <= newSize; ++i ) {
+        _table[i].key = _emptyKey;
+    }
+    if( !old ) {
+        return;
+    }
+    for( Size i = 0; i < oldSize; ++i ) {
+        if( old[i].key == _emptyKey ) {
+            continue;
+        }
+        // no equal keys, take the first vacant slot
+        Size place = _home( old[i].key );
+        while( _table[place].key != _emptyKey ) {
+            place = _next(place);
+        }
+        _table[place].key = old[i].key;
+        _table[place].value = std::move( old[i].value );
+    }
+    _table[newSize].value = std::move( old[oldSize].value );
+    delete [] old;
+}
+
+template<typename KEY, typename VALUE, typename HashT>
+typename myhash_int<KEY, VALUE, HashT>::iterator
+myhash_int<KEY, VALUE, HashT>::begin() const {
+    iterator it = _iterator( _table );
+    if( _table->key == _emptyKey ) { ++it; }
+    return it;
+}
+
+template<typename KEY, typename VALUE, typename HashT>
+typename myhash_int<KEY, VALUE, HashT>::Slot *
+myhash_int<KEY, VALUE, HashT>::_find( const Key & k ) const {
+    if( k == _emptyKey ) {
+        return _hasEmptyKeyEntry ? _table + _tableSize : nullptr_C11;
+    }
+    for( Size place = _home(k); ; place = _next(place) ) {
+        if( _table[place].key == k ) {
+            return _table + place;
+        }
+        if( _table[place].key == _emptyKey ) {
+            return nullptr_C11;
+        }
+    }
+}
+
+template<typename KEY, typename VALUE, typename HashT>
+template<typename ... ArgsT>
+std::pair<typename myhash_int<KEY, VALUE, HashT>::Slot *, bool>
+myhash_int<KEY, VALUE, HashT>::_find_or_insert( const Key & k, ArgsT && ... args ) {
+    if( k == _emptyKey ) {
+        Slot * s = _table + _tableSize;
+        if( _hasEmptyKeyEntry ) {
+            return std::make_pair( s, false );
+        }
+        s->value = Value( std::forward<ArgsT>(args)... );
+        _hasEmptyKeyEntry = true;
+        return std::make_pair( s, true );
+    }
+    Size place = _home(k);
+    for( ; _table[place].key != _emptyKey; place = _next(place) ) {
+        if( _table[place].key == k ) {
+            return std::make_pair( _table + place, false );
+        }
+    }
+    if( _nOccupiedEntries >= _fillmentThreshold ) {
+        if( _tableSize > (std::numeric_limits<Size>::max() >> (_growthShift + 1)) ) {
+            throw std::length_error( "Hash table size limit exceeded." );
+        }
+        _rehash( _tableSize << _growthShift );
+        // remembered slot is lost on growth
+        for( place = _home(k); _table[place].key != _emptyKey; place = _next(place) ) {}
+    }
+    _table[place].value = Value( std::forward<ArgsT>(args)... );
+    _table[place].key = k;
+    ++_nOccupiedEntries;
+    return std::make_pair( _table + place, true );
+}
+
+template<typename KEY, typename VALUE, typename HashT>
+const typename myhash_int<KEY, VALUE, HashT>::Value &
+myhash_int<KEY, VALUE, HashT>::at( const Key & k ) const {
+    const Slot * s = _find(k);
+    if( !s ) {
+        throw std::out_of_range( "Element not found." );
+    }
+    return s->value;
+}
+
+template<typename KEY, typename VALUE, typename HashT> void
+myhash_int<KEY, VALUE, HashT>::erase( const const_iterator & it ) {
+    if( it.slot < _table || it.slot > _table + _tableSize
+     || (it.slot == _table + _tableSize ? !_hasEmptyKeyEntry
+                                        : it.slot->key == _emptyKey) ) {
+        throw std::out_of_range( "Invalid iterator provided." );
+    }
+    if( it.slot == _table + _tableSize ) {
+        it.slot->value = Value();
+        _hasEmptyKeyEntry = false;
+        return;
+    }
+    // Backward shift: the entry following the hole is moved into it unless
+    // its home slot lies between the hole and it (cyclically), i.e. unless
+    // it would become unreachable from its home.
+    const Size mask = _tableSize - 1;
+    Size hole = it.slot - _table;
+    for( Size place = _next(hole); _table[place].key != _emptyKey;
+         place = _next(place) ) {
+        const Size home = _home( _table[place].key );
+        if( ((place - home) & mask) >= ((place - hole) & mask) ) {
+            _table[hole].key = _table[place].key;
+            _table[hole].value = std::move( _table[place].value );
+            hole = place;
+        }
+    }
+    _table[hole].key = _emptyKey;
+    _table[hole].value = Value();
+    --_nOccupiedEntries;
+}
+
+# endif  // H_RDUS_MYHASH_INT_H
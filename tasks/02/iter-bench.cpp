@@ -0,0 +1,143 @@
+# include <string>
+# include <vector>
+# include <iostream>
+# include <random>
+# include <chrono>
+# include <unordered_map>
+
+# include <cstdlib>
+# include <cstdio>
+
+# include "rdus.hpp"
+# include "benchargs.hpp"
+
+//
+// Full scan of myhash<std::string, int> (as for dumping word counts):
+// iterator loop and for_each() versus std::unordered_map iteration, for the
+// table right after growth (load ~0.36) and for the sparse one left after
+// erasing 90% of the keys. Reports ns per visited entry and table scan rate
+// (allocated bytes per second, GB/s). To compare with the former slot by
+// slot iteration, build it twice:
+//  $ g++ -std=c++11 -O2 iter-bench.cpp -o iter-bench
+//  $ g++ -std=c++11 -O2 -DMYHASH_NO_OCCUPANCY_BITMAP iter-bench.cpp -o iter-bench-nob
+//
+// Usage:
+//  $ iter-bench [log2TableSize [nRepeats]]
+
+typedef std::chrono::high_resolution_clock Clock;
+typedef myhash<std::string, int> Hash;
+typedef std::unordered_map<std::string, int> StdMap;
+
+static void
+random_tokens( std::vector<std::string> & dest, size_t n, size_t length,
+               std::mt19937 & rng ) {
+    dest.reserve( dest.size() + n );
+    for( size_t i = 0; i < n; ++i ) {
+        std::string tok( length, ' ' );
+        for( size_t j = 0; j < length; ++j ) {
+            tok[j] = 'a' + rng()%26;
+        }
+        dest.push_back( tok );
+    }
+}
+
+struct Scan {
+    double nsPerEntry, gbPerS;
+};
+
+static Scan
+scan_rate( Clock::time_point s, Clock::time_point e, size_t nEntries,
+           size_t nBytes, size_t nRepeats ) {
+    const double ns = std::chrono::duration<double, std::nano>(e - s).count()/nRepeats;
+    Scan r = { ns/nEntries, nBytes/ns };
+    return r;
+}
+
+static bool
+bench_scan( const char * name, Hash & h, const StdMap & m, size_t nRepeats ) {
+    const size_t n = h.size();
+    long sums[3] = { 0, 0, 0 };
+    Clock::time_point s = Clock::now();
+    for( size_t r = 0; r < nRepeats; ++r ) {
+        for( Hash::iterator it = h.begin(); it != h.end(); ++it ) {
+            sums[0] += it->second;
+        }
+    }
+    const Scan iter = scan_rate( s, Clock::now(), n, h.allocated_bytes(), nRepeats );
+
+    s = Clock::now();
+    for( size_t r = 0; r < nRepeats; ++r ) {
+        h.for_each( [&sums]( const std::string &, int & v ) { sums[1] += v; } );
+    }
+    const Scan forEach = scan_rate( s, Clock::now(), n, h.allocated_bytes(), nRepeats );
+
+    s = Clock::now();
+    for( size_t r = 0; r < nRepeats; ++r ) {
+        for( StdMap::const_iterator it = m.begin(); it != m.end(); ++it ) {
+            sums[2] += it->second;
+        }
+    }
+    const Scan std = scan_rate( s, Clock::now(), n, 0, nRepeats );
+
+    if( m.size() != n || sums[0] != sums[1] || sums[1] != sums[2] ) {
+        std::cerr << "Integrity check failure: " << name << ", sums "
+                  << sums[0] << ", " << sums[1] << ", " << sums[2] << std::endl;
+        return false;
+    }
+    printf( "%-14s%10zu%8.3f%12.2f%8.2f%12.2f%8.2f%12.2f\n", name, n,
+            h.load_factor(), iter.nsPerEntry, iter.gbPerS,
+            forEach.nsPerEntry, forEach.gbPerS, std.nsPerEntry );
+    return true;
+}
+
+int
+main( int argc, const char * argv[] ) {
+    size_t log2Size = 22,
+           nRepeats = 5;
+    if( argc > 3 || (argc > 1 && !bench_number_arg( argv[1], log2Size ))
+     || (argc > 2 && !bench_number_arg( argv[2], nRepeats ))
+     || !nRepeats || log2Size >= 8*sizeof(Hash::Size) ) {
+        std::cerr << "Usage:" << std::endl
+                  << "    $ " << argv[0] << " [log2TableSize [nRepeats]]" << std::endl
+                  ;
+        return EXIT_FAILURE;
+    }
+    // myhash never allocates less than 8 slots
+    if( log2Size < 3 ) {
+        log2Size = 3;
+    }
+    // just over the threshold of the table half as large
+    const size_t nKeys = size_t( 0.71*(size_t(1) << (log2Size - 1)) );
+    std::mt19937 rng(1337);
+    std::vector<std::string> keys;
+    random_tokens( keys, nKeys, 12, rng );
+
+    Hash h;
+    StdMap m;
+    for( size_t i = 0; i < nKeys; ++i ) {
+        h[keys[i]] = m[keys[i]] = int(i % 1000);
+    }
+
+    # ifdef MYHASH_NO_OCCUPANCY_BITMAP
+    const char mode[] = "slot by slot";
+    # else
+    const char mode[] = "occupancy bitmap";
+    # endif
+    printf( "# table size %zu, %s, ns/entry and GB/s of table scanned\n"
+            "%-14s%10s%8s%12s%8s%12s%8s%12s\n", size_t(h.table_size()), mode,
+            "table", "entries", "load", "iterator", "GB/s", "for_each",
+            "GB/s", "std" );
+    if( !bench_scan( "after growth", h, m, nRepeats ) ) {
+        return EXIT_FAILURE;
+    }
+    for( size_t i = 0; i < nKeys; ++i ) {
+        if( i % 10 ) {
+            h.erase( keys[i] );
+            m.erase( keys[i] );
+        }
+    }
+    if( !bench_scan( "90% erased", h, m, nRepeats ) ) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
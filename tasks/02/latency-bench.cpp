@@ -0,0 +1,115 @@
+# include <string>
+# include <vector>
+# include <iostream>
+# include <random>
+# include <chrono>
+# include <algorithm>
+
+# include <cstdlib>
+# include <cstdio>
+
+# include "rdus.hpp"
+# include "benchargs.hpp"
+
+//
+// Per-insertion latency of myhash<std::string, int> growing from the empty
+// table, with stop-the-world growth (myhash_rehash_at_once, the insertion
+// crossing the threshold re-builds whole table) versus incremental growth
+// (myhash_incremental_rehash, each insertion migrates a few slots of the
+// old table). Every insertion is timed individually; reports mean, median,
+// p99, p99.9 and maximum latency along with the total time.
+//
+// Usage:
+//  $ latency-bench [nKeys [keyLength]]
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static void
+random_tokens( std::vector<std::string> & dest, size_t n, size_t length,
+               std::mt19937 & rng ) {
+    dest.reserve( dest.size() + n );
+    for( size_t i = 0; i < n; ++i ) {
+        std::string tok( length, ' ' );
+        for( size_t j = 0; j < length; ++j ) {
+            tok[j] = 'a' + rng()%26;
+        }
+        dest.push_back( tok );
+    }
+}
+
+template<typename TableT> bool
+bench_latency( const char * name, const std::vector<std::string> & keys,
+               std::vector<float> & lat ) {
+    TableT t;
+    const size_t n = keys.size();
+    lat.resize( n );
+    Clock::time_point start = Clock::now();
+    for( size_t i = 0; i < n; ++i ) {
+        Clock::time_point s = Clock::now();
+        t.try_emplace( keys[i], (int) i );
+        Clock::time_point e = Clock::now();
+        lat[i] = std::chrono::duration<float, std::nano>(e - s).count();
+    }
+    const double total = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    for( size_t i = 0; i < n; i += 1 + n/1000 ) {
+        typename TableT::const_iterator it = t.find( keys[i] );
+        if( it == t.end() || it->second != (int) i ) {
+            std::cerr << "Integrity check failure: " << name << ", key #" << i
+                      << " lost." << std::endl;
+            return false;
+        }
+    }
+    if( (size_t) t.size() != n ) {
+        std::cerr << "Integrity check failure: " << name << ", " << t.size()
+                  << " entries instead of " << n << std::endl;
+        return false;
+    }
+    double sum = 0;
+    for( size_t i = 0; i < n; ++i ) {
+        sum += lat[i];
+    }
+    std::sort( lat.begin(), lat.end() );
+    printf( "%-22s%10.1f%10.1f%10.1f%10.1f%12.1f%10.1f\n", name, sum/n,
+            lat[n/2], lat[size_t(n*.99)], lat[size_t(n*.999)], lat[n - 1], total );
+    return true;
+}
+
+int
+main( int argc, const char * argv[] ) {
+    size_t nKeys = 10000000,
+           keyLength = 12;
+    size_t * const args[] = { &nKeys, &keyLength };
+    if( !bench_count_args( argc, argv, args, "[nKeys [keyLength]]" ) ) {
+        return EXIT_FAILURE;
+    }
+    std::mt19937 rng(1337);
+    std::vector<std::string> keys;
+    random_tokens( keys, nKeys, keyLength, rng );
+    std::vector<float> lat;
+
+    typedef myhash_default_hash<std::string> Hash;
+    typedef myhash_default_equals<std::string> Equals;
+    typedef myhash< std::string, int, Hash, Equals
+                  , myhash_linear_probing
+                  , myhash_rehash_at_once > LinearHash;
+    typedef myhash< std::string, int, Hash, Equals
+                  , myhash_linear_probing
+                  , myhash_incremental_rehash<> > LinearIncHash;
+    typedef myhash< std::string, int, Hash, Equals
+                  , myhash_robin_hood_probing
+                  , myhash_rehash_at_once > RobinHoodHash;
+    typedef myhash< std::string, int, Hash, Equals
+                  , myhash_robin_hood_probing
+                  , myhash_incremental_rehash<> > RobinHoodIncHash;
+
+    printf( "# %zu keys of %zu bytes inserted into empty table, ns/insertion\n"
+            "%-22s%10s%10s%10s%10s%12s%10s\n", nKeys, keyLength, "growth",
+            "mean", "p50", "p99", "p99.9", "max", "total,ms" );
+    if( !bench_latency<LinearHash>( "linear, at once", keys, lat )
+     || !bench_latency<LinearIncHash>( "linear, incremental", keys, lat )
+     || !bench_latency<RobinHoodHash>( "RH, at once", keys, lat )
+     || !bench_latency<RobinHoodIncHash>( "RH, incremental", keys, lat ) ) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+# include <string>
+# include <vector>
+# include <iostream>
+# include <random>
+# include <chrono>
+# include <algorithm>
+
+# include <cstdlib>
+# include <cstdio>
+
+# include "swisshash.hpp"
+
+//
+// Entry layout of myhash<std::string, int>: array of HashEntry structures
+// (key, value, two reference members and the hash) versus struct-of-arrays
+// myhash_swiss (control bytes, keys and values in separate arrays). Reports
+// table bytes per slot and per stored entry (not counting heap storage of
+// long strings) and lookup throughput of hits, misses and full iteration.
+//
+// Usage:
+//  $ layout-bench [nKeys [keyLength]]
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static void
+random_tokens( std::vector<std::string> & dest, size_t n, size_t length,
+               std::mt19937 & rng ) {
+    dest.reserve( dest.size() + n );
+    for( size_t i = 0; i < n; ++i ) {
+        std::string tok( length, ' ' );
+        for( size_t j = 0; j < length; ++j ) {
+            tok[j] = 'a' + rng()%26;
+        }
+        dest.push_back( tok );
+    }
+}
+
+static double
+mops( Clock::time_point s, Clock::time_point e, size_t n ) {
+    return n/std::chrono::duration<double, std::micro>(e - s).count();
+}
+
+template<typename TableT> bool
+bench_layout( const char * name,
+              const std::vector<std::string> & keys,
+              const std::vector<std::string> & hitQueries,
+              const std::vector<std::string> & missQueries ) {
+    TableT t;
+    for( size_t i = 0; i < keys.size(); ++i ) {
+        t[keys[i]] = (int) i;
+    }
+    size_t nHits = 0;
+    Clock::time_point s = Clock::now();
+    for( size_t i = 0; i < hitQueries.size(); ++i ) {
+        nHits += t.find( hitQueries[i] ) != t.end();
+    }
+    Clock::time_point e = Clock::now();
+    const double hit = mops( s, e, hitQueries.size() );
+
+    s = Clock::now();
+    for( size_t i = 0; i < missQueries.size(); ++i ) {
+        nHits += t.find( missQueries[i] ) != t.end();
+    }
+    e = Clock::now();
+    const double miss = mops( s, e, missQueries.size() );
+
+    long sum = 0;
+    size_t nIterated = 0;
+    s = Clock::now();
+    for( typename TableT::iterator it = t.begin(); it != t.end(); ++it ) {
+        sum += it->second + (long) it->first.size();
+        ++nIterated;
+    }
+    e = Clock::now();
+    const double iter = mops( s, e, nIterated );
+
+    if( nHits != hitQueries.size() || nIterated != keys.size() ) {
+        std::cerr << "Integrity check failure: " << nHits << " hits, "
+                  << nIterated << " iterated (" << sum << ")." << std::endl;
+        return false;
+    }
+    printf( "%-24s%10.1f%10.1f%10.2f%10.2f%10.2f\n", name,
+            double(t.allocated_bytes())/t.table_size(),
+            double(t.allocated_bytes())/t.size(),
+            hit, miss, iter );
+    return true;
+}
+
+int
+main( int argc, const char * argv[] ) {
+    const size_t nKeys = argc > 1 ? strtoul( argv[1], NULL, 0 ) : 1000000,
+                 keyLength = argc > 2 ? strtoul( argv[2], NULL, 0 ) : 15;
+    std::mt19937 rng(1337);
+
+    std::vector<std::string> keys, hitQueries, missQueries;
+    random_tokens( keys, nKeys, keyLength, rng );
+    hitQueries = keys;
+    std::shuffle( hitQueries.begin(), hitQueries.end(), rng );
+    // longer by one char, so never present
+    random_tokens( missQueries, nKeys, keyLength + 1, rng );
+
+    printf( "# %zu keys of %zu bytes, sizeof(std::string)=%zu, Mops/s\n"
+            "%-24s%10s%10s%10s%10s%10s\n", nKeys, keyLength, sizeof(std::string),
+            "layout", "B/slot", "B/entry", "hit", "miss", "iterate" );
+    if( !bench_layout< myhash<std::string, int> >(
+                "AoS (myhash)", keys, hitQueries, missQueries )
+     || !bench_layout< myhash_swiss<std::string, int> >(
+                "SoA (myhash_swiss)", keys, hitQueries, missQueries ) ) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,199 @@
+# include <string>
+# include <vector>
+# include <iostream>
+# include <random>
+# include <chrono>
+# include <algorithm>
+
+# include <cstdlib>
+# include <cstdio>
+
+# include "rdus.hpp"
+
+//
+// Insertion and lookup latency of myhash<std::string, int>:
+//  - with the hash resolved at compile time (default policy) versus the one
+//    called through runtime function pointer (myhash_runtime_hash). Both use
+//    the same wyhash function;
+//  - for different max load factors and growth factors;
+//  - for weak djb2 hash (that relies on the finalizer mix);
+//  - of tokens referred by (ptr, len) within one text buffer (as produced by
+//    tokenizer), looked up with heterogeneous find() versus by temporary
+//    std::string constructed for every lookup.
+// To compare with the former modulo indexing, build it twice:
+//  $ g++ -std=c++11 -O2 lookup-bench.cpp -o lookup-bench
+//  $ g++ -std=c++11 -O2 -DMYHASH_MODULO_INDEXING lookup-bench.cpp -o lookup-bench-mod
+//
+// Usage:
+//  $ lookup-bench [nKeys [keyLength]]
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static void
+random_tokens( std::vector<std::string> & dest, size_t n, size_t length,
+               std::mt19937 & rng ) {
+    dest.reserve( dest.size() + n );
+    for( size_t i = 0; i < n; ++i ) {
+        std::string tok( length, ' ' );
+        for( size_t j = 0; j < length; ++j ) {
+            tok[j] = 'a' + rng()%26;
+        }
+        dest.push_back( tok );
+    }
+}
+
+struct Timings {
+    double insert, hit, miss;
+};
+
+/// Builds the table with keys and measures average ns per insertion and
+/// per find() of hit and miss queries. Returns false on integrity check
+/// failure.
+template<typename TableT> bool
+bench_lookups( const std::vector<std::string> & keys,
+               const std::vector<std::string> & hitQueries,
+               const std::vector<std::string> & missQueries,
+               Timings & r,
+               float maxLoadFactor=0.7, uint32_t growthFactor=2 ) {
+    TableT t( maxLoadFactor, growthFactor );
+    Clock::time_point s = Clock::now();
+    for( size_t i = 0; i < keys.size(); ++i ) {
+        t[keys[i]] = (int) i;
+    }
+    Clock::time_point e = Clock::now();
+    r.insert = std::chrono::duration<double, std::nano>(e - s).count()/keys.size();
+
+    size_t nHits = 0;
+    s = Clock::now();
+    for( size_t i = 0; i < hitQueries.size(); ++i ) {
+        nHits += t.find( hitQueries[i] ) != t.end();
+    }
+    e = Clock::now();
+    r.hit = std::chrono::duration<double, std::nano>(e - s).count()/hitQueries.size();
+
+    s = Clock::now();
+    for( size_t i = 0; i < missQueries.size(); ++i ) {
+        nHits += t.find( missQueries[i] ) != t.end();
+    }
+    e = Clock::now();
+    r.miss = std::chrono::duration<double, std::nano>(e - s).count()/missQueries.size();
+
+    if( nHits != hitQueries.size() ) {
+        std::cerr << "Integrity check failure: " << nHits << " hits instead of "
+                  << hitQueries.size() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/// Measures average ns per hit lookup of the tokens stored in one buffer,
+/// by (ptr, len) and by temporary std::string.
+template<typename TableT> bool
+bench_views( const std::vector<std::string> & keys,
+             const std::vector<std::string> & hitQueries,
+             double & viewNs, double & stringNs ) {
+    TableT t;
+    for( size_t i = 0; i < keys.size(); ++i ) {
+        t[keys[i]] = (int) i;
+    }
+    std::string buffer;
+    std::vector<std::pair<size_t, size_t> > tokens;
+    for( size_t i = 0; i < hitQueries.size(); ++i ) {
+        tokens.push_back( std::make_pair( buffer.size(), hitQueries[i].size() ) );
+        buffer += hitQueries[i];
+        buffer += ' ';
+    }
+    size_t nHits = 0;
+    Clock::time_point s = Clock::now();
+    for( size_t i = 0; i < tokens.size(); ++i ) {
+        nHits += t.find( buffer.data() + tokens[i].first, tokens[i].second ) != t.end();
+    }
+    Clock::time_point e = Clock::now();
+    viewNs = std::chrono::duration<double, std::nano>(e - s).count()/tokens.size();
+
+    s = Clock::now();
+    for( size_t i = 0; i < tokens.size(); ++i ) {
+        nHits += t.find( std::string( buffer.data() + tokens[i].first,
+                                      tokens[i].second ) ) != t.end();
+    }
+    e = Clock::now();
+    stringNs = std::chrono::duration<double, std::nano>(e - s).count()/tokens.size();
+
+    if( nHits != 2*tokens.size() ) {
+        std::cerr << "Integrity check failure: " << nHits << " hits instead of "
+                  << 2*tokens.size() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static void
+print_row( const char * name, const Timings & t ) {
+    printf( "%-32s%10.2f%10.2f%10.2f\n", name, t.insert, t.hit, t.miss );
+}
+
+int
+main( int argc, const char * argv[] ) {
+    const size_t nKeys = argc > 1 ? strtoul( argv[1], NULL, 0 ) : 1000000,
+                 keyLength = argc > 2 ? strtoul( argv[2], NULL, 0 ) : 15;
+    std::mt19937 rng(1337);
+
+    std::vector<std::string> keys, hitQueries, missQueries;
+    random_tokens( keys, nKeys, keyLength, rng );
+    hitQueries = keys;
+    std::shuffle( hitQueries.begin(), hitQueries.end(), rng );
+    // longer by one char, so never present
+    random_tokens( missQueries, nKeys, keyLength + 1, rng );
+
+    # ifdef MYHASH_MODULO_INDEXING
+    const char indexing[] = "modulo";
+    # else
+    const char indexing[] = "mask+fmix32";
+    # endif
+    printf( "# %zu keys of %zu bytes, %s indexing, ns/op\n%-32s%10s%10s%10s\n",
+            nKeys, keyLength, indexing, "configuration", "insert", "hit", "miss" );
+
+    typedef myhash<std::string, int> CompileTimeHash;
+    typedef myhash_runtime_hash<std::string> RuntimePolicy;
+    typedef myhash<std::string, int, RuntimePolicy> RuntimeHash;
+
+    Timings t;
+    if( !bench_lookups<RuntimeHash>( keys, hitQueries, missQueries, t ) ) {
+        return EXIT_FAILURE;
+    }
+    print_row( "runtime pointer, 0.7, x2", t );
+
+    const struct {
+        float maxLoad;
+        uint32_t growth;
+        const char * name;
+    } configs[] = {
+        { 0.7,  2, "compile-time policy, 0.7, x2" },
+        { 0.7,  4, "compile-time policy, 0.7, x4" },
+        { 0.5,  2, "compile-time policy, 0.5, x2" },
+        { 0.875, 2, "compile-time policy, 0.875, x2" },
+    };
+    for( size_t i = 0; i < sizeof(configs)/sizeof(*configs); ++i ) {
+        if( !bench_lookups<CompileTimeHash>( keys, hitQueries, missQueries, t,
+                                configs[i].maxLoad, configs[i].growth ) ) {
+            return EXIT_FAILURE;
+        }
+        print_row( configs[i].name, t );
+    }
+
+    RuntimePolicy::set_function( djb2 );
+    if( !bench_lookups<RuntimeHash>( keys, hitQueries, missQueries, t ) ) {
+        return EXIT_FAILURE;
+    }
+    print_row( "djb2 (runtime pointer), 0.7, x2", t );
+
+    double viewNs, stringNs;
+    if( !bench_views<CompileTimeHash>( keys, hitQueries, viewNs, stringNs ) ) {
+        return EXIT_FAILURE;
+    }
+    printf( "%-32s%10s%10.2f%10s\n%-32s%10s%10.2f%10s\n",
+            "hit by (ptr, len)", "-", viewNs, "-",
+            "hit by temporary std::string", "-", stringNs, "-" );
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+# include <string>
+# include <vector>
+# include <iostream>
+# include <random>
+# include <chrono>
+
+# include <cstdlib>
+# include <cstdio>
+
+# include "mappedhash.hpp"
+
+//
+// Startup cost of myhash<std::string, int>: building the table from words
+// (what services do at every start) versus opening its snapshot written by
+// save() with myhash_mapped::open_mapped(), for growing number of keys.
+// Reports build time, save time and file size, open time, latency of the
+// first lookup after opening (page faults included) and lookup rate of the
+// mapped snapshot versus the in-memory table. The snapshot is written to
+// given path (replaced for every size, removed at exit).
+//
+// Usage:
+//  $ mapped-bench [path [maxKeys [nQueries]]]
+
+typedef std::chrono::high_resolution_clock Clock;
+typedef myhash<std::string, int> Hash;
+typedef myhash_mapped<int> MappedHash;
+
+static void
+random_tokens( std::vector<std::string> & dest, size_t n, size_t length,
+               std::mt19937 & rng ) {
+    dest.reserve( dest.size() + n );
+    for( size_t i = 0; i < n; ++i ) {
+        std::string tok( length, ' ' );
+        for( size_t j = 0; j < length; ++j ) {
+            tok[j] = 'a' + rng()%26;
+        }
+        dest.push_back( tok );
+    }
+}
+
+static double
+us_since( Clock::time_point s ) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - s).count();
+}
+
+template<typename TableT> double
+lookup_ns( const TableT & t, const std::vector<std::string> & queries, long & sum ) {
+    Clock::time_point s = Clock::now();
+    for( size_t i = 0; i < queries.size(); ++i ) {
+        typename TableT::const_iterator it = t.find( queries[i] );
+        if( it != t.end() ) {
+            sum += it->second;
+        }
+    }
+    return 1e3*us_since( s )/queries.size();
+}
+
+static bool
+bench_startup( const char * path, const std::vector<std::string> & words,
+               size_t nKeys, size_t nQueries, std::mt19937 & rng ) {
+    Hash h;
+    Clock::time_point s = Clock::now();
+    for( size_t i = 0; i < nKeys; ++i ) {
+        h[words[i]] = (int) i;
+    }
+    const double buildMs = us_since( s )*1e-3;
+    s = Clock::now();
+    h.save( path );
+    const double saveMs = us_since( s )*1e-3;
+
+    s = Clock::now();
+    MappedHash m( path );
+    const double openUs = us_since( s );
+    const std::string & first = words[rng()%nKeys];
+    s = Clock::now();
+    const int firstValue = m.at( first );
+    const double firstUs = us_since( s );
+
+    std::vector<std::string> queries;
+    for( size_t i = 0; i < nQueries; ++i ) {
+        queries.push_back( words[rng()%nKeys] );
+    }
+    long sums[2] = { 0, 0 };
+    const double mappedNs = lookup_ns( m, queries, sums[0] ),
+                 memoryNs = lookup_ns( h, queries, sums[1] );
+    if( m.size() != h.size() || sums[0] != sums[1] || firstValue != h.at( first ) ) {
+        std::cerr << "Integrity check failure: " << m.size() << " mapped entries of "
+                  << h.size() << ", sums " << sums[0] << ", " << sums[1] << std::endl;
+        return false;
+    }
+    printf( "%10zu%12.1f%10.1f%10.1f%10.1f%10.1f%12.1f%12.1f\n", nKeys, buildMs,
+            saveMs, m.mapped_bytes()/1048576., openUs, firstUs, mappedNs, memoryNs );
+    return true;
+}
+
+int
+main( int argc, const char * argv[] ) {
+    const char * path = argc > 1 ? argv[1] : "myhash-bench.snapshot";
+    const size_t maxKeys = argc > 2 ? strtoul( argv[2], NULL, 0 ) : 4000000,
+                 nQueries = argc > 3 ? strtoul( argv[3], NULL, 0 ) : 1000000;
+    std::mt19937 rng(1337);
+    std::vector<std::string> words;
+    random_tokens( words, maxKeys, 12, rng );
+
+    printf( "# snapshot %s\n%10s%12s%10s%10s%10s%10s%12s%12s\n", path, "keys",
+            "build,ms", "save,ms", "MB", "open,us", "first,us", "mapped,ns",
+            "memory,ns" );
+    for( size_t n = maxKeys/64 ? maxKeys/64 : 1; ; n *= 4 ) {
+        if( n > maxKeys ) {
+            n = maxKeys;
+        }
+        if( !bench_startup( path, words, n, nQueries, rng ) ) {
+            remove( path );
+            return EXIT_FAILURE;
+        }
+        if( n == maxKeys ) {
+            break;
+        }
+    }
+    remove( path );
+    return EXIT_SUCCESS;
+}
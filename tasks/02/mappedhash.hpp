@@ -0,0 +1,235 @@
+# ifndef H_RDUS_MYHASH_MAPPED_H
+# define H_RDUS_MYHASH_MAPPED_H
+
+# include "rdus.hpp"
+
+# include <string>
+
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <unistd.h>
+
+//
+// Read-only view of the table snapshot written by myhash<std::string,
+// VALUE>::save() (see myhash_snapshot_header for the layout). open_mapped()
+// only maps the file and checks its header -- nothing is read or parsed,
+// the pages are faulted in by the lookups touching them -- so it takes the
+// same time for any table size, and the pages are shared by all processes
+// mapping the same file.
+//
+// Lookups follow myhash: find() returns iterator (end() if key is absent)
+// with ->first/->second and ->key/->value, at() throws std::out_of_range;
+// keys may be given as std::string, character sequence or
+// myhash_string_ref, and the iterator gives the key as myhash_string_ref
+// pointing into the mapping. Hash policy must be the same the table was
+// saved with (checked on opening).
+//
+// The file is trusted: only the header is validated, not the slots. The
+// mapping stays valid until close() (or destruction) even if the file is
+// replaced by the next save() meanwhile.
+
+template<typename VALUE, typename HashT=myhash_default_hash<std::string> >
+class myhash_mapped {
+public:
+    typedef uint32_t Size;
+    typedef VALUE Value;
+    typedef HashT Hash;
+    typedef myhash_mapped<Value, Hash> Self;
+    typedef myhash_snapshot_slot<Value> Slot;
+
+    /// Proxy returned by iterator dereference.
+    struct Reference {
+        myhash_string_ref first;
+        const Value & second;
+        myhash_string_ref key;
+        const Value & value;
+
+        Reference( const Slot & s, const char * blob ) :
+                    first( blob + s.keyOffset, s.keyLength ), second( s.value ),
+                    key( first ), value( s.value ) {}
+        /// Makes iterator's operator->() chain to the members.
+        Reference * operator->() { return this; }
+    };
+
+    struct iterator {
+        const Slot * slot,
+                   * slotsEnd;
+        const char * blob;
+
+        iterator( const Slot * s, const Slot * sEnd, const char * b ) :
+                    slot(s), slotsEnd(sEnd), blob(b) {}
+
+        /// Moves to the next occupied slot (or to the end).
+        iterator & operator++() {
+            do { ++slot; } while( slot != slotsEnd && !slot->hashValue );
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator it(*this);
+            ++(*this);
+            return it;
+        }
+        Reference operator->() const { return Reference( *slot, blob ); }
+        Reference operator*() const { return Reference( *slot, blob ); }
+
+        friend bool operator!= (const iterator & l,
+                                const iterator & r) { return l.slot != r.slot; }
+        friend bool operator== (const iterator & l,
+                                const iterator & r) { return ! (l != r); }
+    };
+    typedef iterator const_iterator;
+private:
+    void * _map;
+    size_t _mapSize;
+    const myhash_snapshot_header * _header;
+    const Slot * _slots;
+    const char * _blob;
+    Size _mask;
+protected:
+    iterator _iterator( const Slot * s ) const {
+        return iterator( s, _slots + table_size(), _blob ); }
+    /// Returns the slot of the key or null.
+    const Slot * _find( const myhash_string_ref & r ) const;
+public:
+    myhash_mapped() : _map( nullptr_C11 ), _mapSize( 0 ), _header( nullptr_C11 ),
+                      _slots( nullptr_C11 ), _blob( nullptr_C11 ), _mask( 0 ) {}
+    /// Same as open_mapped() on the default-constructed instance.
+    explicit myhash_mapped( const char * path ) : myhash_mapped() { open_mapped( path ); }
+    ~myhash_mapped() { close(); }
+
+    myhash_mapped( const Self & ) = delete;
+    Self & operator=( const Self & ) = delete;
+
+    /// Maps the snapshot file read-only, replacing the former mapping (if
+    /// any). Throws std::runtime_error if the file can not be mapped or is
+    /// not a snapshot of this value type and hash function; the former
+    /// mapping is kept then.
+    void open_mapped( const char * path );
+    /// Unmaps the snapshot, if mapped.
+    void close();
+    bool is_open() const { return _map; }
+
+    iterator begin() const;
+    iterator end() const { return _iterator( _slots + table_size() ); }
+
+    iterator find( const myhash_string_ref & r ) const {
+        const Slot * s = _find(r);
+        return s ? _iterator( s ) : end(); }
+    iterator find( const std::string & k ) const { return find( myhash_string_ref(k) ); }
+    iterator find( const char * s ) const { return find( myhash_string_ref(s) ); }
+    iterator find( const char * s, size_t l ) const { return find( myhash_string_ref(s, l) ); }
+
+    const Value & at( const myhash_string_ref & r ) const;
+    const Value & at( const std::string & k ) const { return at( myhash_string_ref(k) ); }
+    const Value & operator[]( const myhash_string_ref & r ) const { return at(r); }
+    const Value & operator[]( const std::string & k ) const { return at(k); }
+
+    int size() const { return _header ? (int) _header->nEntries : 0; }
+    Size table_size() const { return _header ? _header->tableSize : 0; }
+    /// Size of the mapped file.
+    size_t mapped_bytes() const { return _mapSize; }
+};  // class myhash_mapped
+
+// Implementation
+////////////////
+
+template<typename VALUE, typename HashT> void
+myhash_mapped<VALUE, HashT>::open_mapped( const char * path ) {
+    const int fd = ::open( path, O_RDONLY );
+    if( fd < 0 ) {
+        throw std::runtime_error( "Unable to open \"" + std::string(path) + "\"." );
+    }
+    struct stat st;
+    void * map = MAP_FAILED;
+    if( !fstat( fd, &st ) && size_t(st.st_size) >= sizeof(myhash_snapshot_header) ) {
+        map = mmap( nullptr_C11, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+    }
+    ::close( fd );  // mapping keeps the file
+    if( MAP_FAILED == map ) {
+        throw std::runtime_error( "Unable to map \"" + std::string(path) + "\"." );
+    }
+    const size_t size = st.st_size;
+    const myhash_snapshot_header * h = static_cast<const myhash_snapshot_header *>(map);
+    const char * error = nullptr_C11;
+    if( memcmp( h->magic, myhash_snapshot_magic, sizeof(h->magic) ) ) {
+        error = "is not a myhash snapshot (or of other format version)";
+    } else if( h->slotSize != sizeof(Slot) || h->valueSize != sizeof(Value) ) {
+        error = "holds values of other type";
+    } else if( !h->tableSize || (h->tableSize & (h->tableSize - 1))
+            || h->slotsOffset % alignof(Slot)
+            || h->slotsOffset + uint64_t(h->slotSize)*h->tableSize > h->blobOffset
+            || h->blobOffset + h->blobSize > size ) {
+        error = "is truncated or corrupted";
+    } else if( h->hashCheck != Hash::hash( myhash_string_ref( "myhash", 6 ) ) ) {
+        error = "was saved with other hash function";
+    }
+    if( error ) {
+        munmap( map, size );
+        throw std::runtime_error( "Snapshot \"" + std::string(path) + "\" " + error + "." );
+    }
+    // lookups touch random pages, read-ahead would only waste the page cache
+    madvise( map, size, MADV_RANDOM );
+    close();
+    _map = map;
+    _mapSize = size;
+    _header = h;
+    _slots = reinterpret_cast<const Slot *>( static_cast<const char *>(map) + h->slotsOffset );
+    _blob = static_cast<const char *>(map) + h->blobOffset;
+    _mask = h->tableSize - 1;
+}
+
+template<typename VALUE, typename HashT> void
+myhash_mapped<VALUE, HashT>::close() {
+    if( _map ) {
+        munmap( _map, _mapSize );
+    }
+    _map = nullptr_C11;
+    _mapSize = 0;
+    _header = nullptr_C11;
+    _slots = nullptr_C11;
+    _blob = nullptr_C11;
+    _mask = 0;
+}
+
+template<typename VALUE, typename HashT>
+typename myhash_mapped<VALUE, HashT>::iterator
+myhash_mapped<VALUE, HashT>::begin() const {
+    iterator it = _iterator( _slots );
+    if( it != end() && !_slots->hashValue ) { ++it; }
+    return it;
+}
+
+template<typename VALUE, typename HashT>
+const typename myhash_mapped<VALUE, HashT>::Slot *
+myhash_mapped<VALUE, HashT>::_find( const myhash_string_ref & r ) const {
+    if( !_map ) {
+        return nullptr_C11;
+    }
+    const uint32_t hv = myhash_snapshot_hash( Hash::hash(r) ),
+                   tag = (hv << 1) | 0x1;
+    Size place = hv & _mask;
+    for( Size n = 0; n <= _mask; ++n, place = (place + 1) & _mask ) {
+        const Slot & s = _slots[place];
+        if( !s.hashValue ) {
+            break;
+        }
+        if( s.hashValue == tag && s.keyLength == r.size
+         && !memcmp( _blob + s.keyOffset, r.data, r.size ) ) {
+            return &s;
+        }
+    }
+    return nullptr_C11;
+}
+
+template<typename VALUE, typename HashT>
+const typename myhash_mapped<VALUE, HashT>::Value &
+myhash_mapped<VALUE, HashT>::at( const myhash_string_ref & r ) const {
+    const Slot * s = _find(r);
+    if( !s ) {
+        throw std::out_of_range( "Element not found." );
+    }
+    return s->value;
+}
+
+# endif  // H_RDUS_MYHASH_MAPPED_H
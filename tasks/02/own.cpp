@@ -93,6 +93,65 @@ integrity_test( size_t nEntries ) {
     return 0;
 }
 
+/// Fills tables of low max load factor, where the growth threshold of the
+/// smallest table is less than 4 slots.
+int
+low_load_test( size_t nEntries ) {
+    const float loads[] = { 0.2f, 0.3f, 0.45f };
+    for( size_t i = 0; i < sizeof(loads)/sizeof(*loads); ++i ) {
+        myhash<std::string, int> h( loads[i] );
+        for( size_t n = 0; n < nEntries; ++n ) {
+            h[std::to_string(n)] = (int) n;
+        }
+        if( (size_t) h.size() != nEntries || h.load_factor() > loads[i] ) {
+            return 1;
+        }
+        for( size_t n = 0; n < nEntries; n += 2 ) {
+            h.erase( std::to_string(n) );
+        }
+        for( size_t n = 0; n < nEntries; ++n ) {
+            h[std::to_string(n + nEntries)] = (int) n;
+        }
+        for( size_t n = 1; n < nEntries; n += 2 ) {
+            if( h[std::to_string(n)] != (int) n
+             || h[std::to_string(n + nEntries)] != (int) n ) {
+                return 2;
+            }
+        }
+    }
+    return 0;
+}
+
+/// Looks up the keys while incremental growth migrates the old table:
+/// iterator to any of them (possibly into the old table) must reach end()
+/// passing no more entries than there are.
+template<typename ProbingT> int
+migration_iter_test() {
+    typedef myhash< std::string, int, myhash_default_hash<std::string>,
+                    myhash_default_equals<std::string>, ProbingT,
+                    myhash_incremental_rehash<> > Hash;
+    Hash h;
+    size_t nEntries = 0;
+    while( !h.migrating() ) {
+        h[std::to_string(nEntries)] = (int) nEntries;
+        ++nEntries;
+    }
+    for( size_t n = 0; n < nEntries; ++n ) {
+        typename Hash::iterator it = h.find( std::to_string(n) );
+        if( it == h.end() || it->second != (int) n ) {
+            return 1;
+        }
+        size_t nPassed = 0;
+        while( it != h.end() ) {
+            if( ++nPassed > nEntries ) {
+                return 2;
+            }
+            it++;
+        }
+    }
+    return h.migrating() ? 0 : 3;
+}
+
 int
 main( int argc, const char * argv[] ) {
 
@@ -102,6 +161,19 @@ main( int argc, const char * argv[] ) {
     }
     printf( "Integrity test passed.\n" );
 
+    if( low_load_test( 300 ) ) {
+        fprintf(stderr, "Error: low load factor test failed.\n");
+        return EXIT_FAILURE;
+    }
+    printf( "Low load factor test passed.\n" );
+
+    if( migration_iter_test<myhash_linear_probing>()
+     || migration_iter_test<myhash_robin_hood_probing>() ) {
+        fprintf(stderr, "Error: iteration during migration test failed.\n");
+        return EXIT_FAILURE;
+    }
+    printf( "Iteration during migration test passed.\n" );
+
     return EXIT_SUCCESS;
 }
 
@@ -5,6 +5,20 @@
 # include <stdexcept>
 # include <cstdint>
 # include <cstdio>
+# include <cstring>
+# include <limits>
+# include <utility>
+# include <algorithm>
+# include <new>
+# include <string>
+# include <vector>
+# include <type_traits>
+# if __cplusplus >= 201703L
+# include <string_view>
+# endif
+# ifdef MYHASH_COLLECT_STATS
+# include <chrono>
+# endif
 
 # if __cplusplus <= 199711L
 # define nullptr_C11 NULL
@@ -18,10 +32,253 @@
 #   define printout(...)
 # endif
 
+# ifdef __GNUC__
+#   define MYHASH_PREFETCH(p) __builtin_prefetch( (p) )
+# else
+#   define MYHASH_PREFETCH(p)
+# endif
+
+// Define MYHASH_MODULO_INDEXING to get the former slot indexing (division
+// by table size on every probe, no finalizer) for benchmarking purposes.
+// Define MYHASH_NO_STORED_HASH to get the former key comparison (no check of
+// stored hash before calling equals) and growth (re-hashing every key).
+// Define MYHASH_COLLECT_STATS to collect probe length histograms and growth
+// statistics (see myhash_stats); otherwise nothing is collected.
+// Define MYHASH_NO_OCCUPANCY_BITMAP to get the former iteration (slot by
+// slot, checking every entry) for benchmarking purposes.
+
+/// Reference to character sequence used for heterogeneous lookup of string
+/// keys (C++11 substitute of std::string_view, implicitly constructible from
+/// it). Must be hashed and compared the same way as the key it refers to.
+struct myhash_string_ref {
+    const char * data;
+    size_t size;
+
+    myhash_string_ref( const char * d, size_t l ) : data(d), size(l) {}
+    explicit myhash_string_ref( const char * s ) : data(s), size(strlen(s)) {}
+    explicit myhash_string_ref( const std::string & s ) : data(s.data()), size(s.size()) {}
+    # if __cplusplus >= 201703L
+    myhash_string_ref( std::string_view v ) : data(v.data()), size(v.size()) {}
+    # endif
+};
+
+/// Enables lookup overloads taking C string (CharT deduced as char) for the
+/// tables of string-like keys only (constructible from character sequence),
+/// so that literal 0 is not ambiguous for the integer keys.
+template<typename KeyT, typename CharT, typename ResultT>
+struct myhash_if_c_string : std::enable_if<
+        std::is_same<CharT, char>::value
+     && std::is_constructible<KeyT, const CharT *, size_t>::value, ResultT> {};
+
 template<typename T> uint32_t myhash_hash_spec( const T & );
 template<typename T> bool myhash_equals( const T & l, const T & r );
+template<typename T> bool myhash_equals( const T & l, const myhash_string_ref & r );
+
+/// Prefetches out-of-line storage of the key (if any) for batched lookups.
+/// Overload it for other key types holding their data on heap.
+template<typename T> inline void myhash_prefetch_key( const T & ) {}
+inline void myhash_prefetch_key( const std::string & s ) { MYHASH_PREFETCH( s.data() ); }
+inline void myhash_prefetch_key( const myhash_string_ref & r ) { MYHASH_PREFETCH( r.data ); }
+
+/// Default hashing policy: myhash_hash_spec<> specialization, resolved (and
+/// may be inlined) at compile time.
+template<typename T>
+struct myhash_default_hash {
+    static uint32_t hash( const T & k ) { return myhash_hash_spec<T>(k); }
+    static uint32_t hash( const myhash_string_ref & r ) {
+        return myhash_hash_spec<myhash_string_ref>(r); }
+};
+
+/// Default key comparison policy: myhash_equals<> specialization.
+template<typename T>
+struct myhash_default_equals {
+    static bool equals( const T & l, const T & r ) { return myhash_equals<T>(l, r); }
+    static bool equals( const T & l, const myhash_string_ref & r ) {
+        return myhash_equals<T>(l, r); }
+};
+
+/// Hashing policy calling byte sequence hash function through the pointer
+/// that may be switched at runtime. Meant for benchmarking only: it blocks
+/// inlining and the pointer is shared by all tables using this policy.
+template<typename T>
+struct myhash_runtime_hash {
+    typedef uint32_t (*HashFunction)( const uint8_t *, uint32_t );
+    static HashFunction function;
 
-template<typename KEY, typename VALUE>
+    static void set_function( HashFunction f ) { function = f; }
+    static uint32_t hash( const T & k ) {
+        return function( (const uint8_t *) k.data(), k.size() ); }
+    static uint32_t hash( const myhash_string_ref & r ) {
+        return function( (const uint8_t *) r.data, r.size ); }
+};
+
+/// Murmur3 32-bit finalizer: spreads (weak) hash over all the bits, so any
+/// bit subset taken by mask depends on the whole hash.
+inline uint32_t
+myhash_fmix32( uint32_t h ) {
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+/// Murmur3 64-bit finalizer.
+inline uint64_t
+myhash_fmix64( uint64_t h ) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/// Hash of integer key: murmur3 finalizer of its value (64-bit one, folded
+/// to 32 bits, for the wider types), so that sequential or strided keys
+/// spread over the whole table.
+template<typename T> inline uint32_t
+myhash_integer_hash( T v ) {
+    if( sizeof(T) <= sizeof(uint32_t) ) {
+        return myhash_fmix32( (uint32_t) v );
+    }
+    const uint64_t h = myhash_fmix64( (uint64_t) v );
+    return (uint32_t) (h ^ (h >> 32));
+}
+
+/// Index of the lowest set bit, x must not be zero.
+inline unsigned
+myhash_ctz64( uint64_t x ) {
+    # ifdef __GNUC__
+    return __builtin_ctzll( x );
+    # else
+    unsigned n = 0;
+    for( ; !(x & 1); x >>= 1 ) ++n;
+    return n;
+    # endif
+}
+
+/// Probing policy: linear probing, erased entries are marked with tombstone
+/// flag.
+struct myhash_linear_probing {
+    static const bool robinHood = false;
+};
+
+/// Probing policy: linear probing with Robin Hood insertion (entry that is
+/// closer to its home slot yields place to the one that is farther) and
+/// backward-shift deletion, so the table never holds tombstones and lookup
+/// for absent key stops as soon as it meets entry closer to its home than
+/// the probe. Mind, that erasure shifts entries, so erasing while iterating
+/// may skip entries.
+struct myhash_robin_hood_probing {
+    static const bool robinHood = true;
+};
+
+/// Growth policy: the table is re-built at once by the insertion that
+/// crosses the load threshold (stop-the-world).
+struct myhash_rehash_at_once {
+    static const bool incremental = false;
+    static const uint32_t migrationStep = 0;
+};
+
+/// Growth policy: on growth the old table is kept aside and each following
+/// insertion/erasure migrates next MigrationStepT slots of it to the new
+/// one, so no single operation pays for the whole rehash. Lookups consult
+/// both tables while migration is in progress; migrated slots of the old
+/// table are left as tombstones to keep its probe sequences intact. If the
+/// new table reaches its threshold before migration is done (or on
+/// begin()), the rest is migrated at once. The storage of the next table
+/// is constructed ahead by the insertions approaching the threshold,
+/// MigrationStepT entries at a time, for the same reason.
+/// Iterator found in the old table is incremented through the rest of it
+/// and then through the new one; as any iterator, it is invalidated by
+/// the following insertion/erasure (these move entries).
+template<uint32_t MigrationStepT=64>
+struct myhash_incremental_rehash {
+    static const bool incremental = true;
+    static const uint32_t migrationStep = MigrationStepT;
+};
+
+# ifdef MYHASH_COLLECT_STATS
+/// Operation statistics of myhash: probe lengths of lookups that found the
+/// key (hits) and of the ones that did not (misses, including the probes
+/// preceding insertion), number of growths and time spent on them (with
+/// incremental growth -- on the migration steps too).
+struct myhash_stats {
+    static const unsigned nBins = 32;  // the last bin counts longer probes
+    uint64_t hits[nBins],
+             misses[nBins],
+             nGrowths,
+             growthNs;
+
+    myhash_stats() { reset(); }
+    void reset() {
+        for( unsigned i = 0; i < nBins; ++i ) hits[i] = misses[i] = 0;
+        nGrowths = growthNs = 0;
+    }
+    void count_probe( bool hit, uint32_t depth ) {
+        ++(hit ? hits : misses)[depth < nBins - 1 ? depth : nBins - 1];
+    }
+    /// Adds its lifetime to growthNs.
+    struct GrowthTimer {
+        myhash_stats & stats;
+        std::chrono::steady_clock::time_point start;
+        GrowthTimer( myhash_stats & s ) : stats(s),
+                                          start( std::chrono::steady_clock::now() ) {}
+        ~GrowthTimer() {
+            stats.growthNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start ).count();
+        }
+    };
+};
+# endif
+
+// Immutable minimal perfect hash table made by myhash::freeze() and its
+// seeded 64-bit hash policy, defined in frozenhash.hpp.
+template<typename T> struct myhash_default_hash64;
+template<typename KEY, typename VALUE, typename Hash64T, typename EqualsT>
+class myhash_frozen;
+
+/// Flat snapshot of the table with string keys, written by myhash::save()
+/// and mapped by myhash_mapped (mappedhash.hpp): the header, tableSize slots
+/// (starting at slotsOffset) and the blob of key characters (at blobOffset).
+/// There are no pointers, only offsets from the file start, so the file may
+/// be mapped at any address and queried as is. Keys are placed by linear
+/// probing on myhash_snapshot_hash(), regardless of the indexing macros the
+/// table was built with.
+struct myhash_snapshot_header {
+    char magic[8];  // "MYHSNAP" and format version
+    uint32_t slotSize,  // sizeof(myhash_snapshot_slot<Value>)
+             valueSize,
+             tableSize,  // always a power of two
+             nEntries,
+             hashCheck,  // hash of "myhash" by the hash function used
+             reserved;
+    uint64_t slotsOffset,
+             blobOffset,
+             blobSize;
+};
+
+template<typename VALUE>
+struct myhash_snapshot_slot {
+    uint32_t hashValue,  // (hash << 1) | 1 if occupied, 0 if vacant
+             keyLength;
+    uint64_t keyOffset;  // in the blob
+    VALUE value;
+};
+
+static const char myhash_snapshot_magic[8] = { 'M', 'Y', 'H', 'S', 'N', 'A', 'P', 1 };
+
+/// 31-bit hash of the snapshot layout, for the key's hash.
+inline uint32_t
+myhash_snapshot_hash( uint32_t h ) { return myhash_fmix32( h ) >> 1; }
+
+template<typename KEY, typename VALUE,
+         typename HashT=myhash_default_hash<KEY>,
+         typename EqualsT=myhash_default_equals<KEY>,
+         typename ProbingT=myhash_linear_probing,
+         typename GrowthT=myhash_rehash_at_once >
 class myhash
 {
 public:
@@ -29,32 +286,87 @@ public:
     typedef uint32_t HashValue;
     typedef KEY Key;
     typedef VALUE Value;
-    typedef HashValue (*HashFunction)( const uint8_t *, Size );
-    typedef myhash<Key, Value> Self;
+    typedef HashT Hash;
+    typedef EqualsT Equals;
+    typedef ProbingT Probing;
+    typedef GrowthT Growth;
+    typedef myhash<Key, Value, Hash, Equals, Probing, Growth> Self;
+    /// Key and value are constructed only while the entry is valid (their
+    /// storage is in anonymous unions), so vacant slots and tombstones hold
+    /// no objects and table allocation constructs no keys.
     struct HashEntry {
-		Key key;  // ref for spec compat
-		const Key & first;
-		Value value;
-		Value & second;  // ref for spec compat
+        union { Key key; };
+        const Key & first;  // ref for spec compat
+        union { Value value; };
+        Value & second;  // ref for spec compat
         /// Two last bits are reserved for tombstone flag and occupancy flag
         /// correspondingly.
         HashValue hashValue;
 
-        HashEntry() : hashValue(0), first(key), second(value) {}
+        HashEntry() : first(key), second(value), hashValue(0) {}
+        ~HashEntry() { if( is_valid() ) _destroy(); }
+
+        /// Copies key and value of the valid entry (so by-value range-for
+        /// works); the copy of vacant entry or tombstone is vacant.
+        HashEntry( const HashEntry & o ) : first(key), second(value),
+                                           hashValue(0) {
+            if( o.is_valid() ) {
+                new (&key) Key( o.key );
+                try {
+                    new (&value) Value( o.value );
+                } catch( ... ) {
+                    key.~Key();
+                    throw;
+                }
+                hashValue = o.hashValue;
+            }
+        }
+        HashEntry & operator=( const HashEntry & ) = delete;
 
         /// true, if is not occupied and wasn't occupied.
         bool is_vacant() const { return !((hashValue & 0x1) || (hashValue & 0x2)); }
         bool is_occupied() const { return hashValue & 0x1; }
-        void release() { hashValue |= 0x2; hashValue &= ~0x1; }
-        bool is_released() { return hashValue & 0x2; }
-        void set( const Key & k, const Value & v, HashValue hv ) {
-            key = k;
-            value = v;
+        /// Destroys key and value, leaving the tombstone.
+        void release() { _destroy(); hashValue |= 0x2; hashValue &= ~0x1; }
+        bool is_released() const { return hashValue & 0x2; }
+        /// Constructs key and value in the non-valid entry. Value is
+        /// constructed from args (value-initialized if none given).
+        template<typename K, typename ... ArgsT>
+        void set( HashValue hv, K && k, ArgsT && ... args ) {
+            new (&key) Key( std::forward<K>(k) );
+            try {
+                new (&value) Value( std::forward<ArgsT>(args)... );
+            } catch( ... ) {
+                key.~Key();
+                throw;
+            }
             hashValue = (hv << 2) | 0x1;
         }
         bool is_valid() const {
             return (0x1 & hashValue) && !( 0x2 & hashValue );
         }
+        /// Makes entry vacant (no tombstone).
+        void vacate() {
+            if( is_valid() ) _destroy();
+            hashValue = 0;
+        }
+        /// Move-constructs content of the valid entry o in this non-valid
+        /// one, making o vacant.
+        void relocate_from( HashEntry & o ) {
+            new (&key) Key( std::move(o.key) );
+            new (&value) Value( std::move(o.value) );
+            hashValue = o.hashValue;
+            o.vacate();
+        }
+        /// Exchanges the content (but not the references) with other entry,
+        /// both must be valid.
+        void swap( HashEntry & o ) {
+            std::swap( key, o.key );
+            std::swap( value, o.value );
+            std::swap( hashValue, o.hashValue );
+        }
+    private:
+        void _destroy() { key.~Key(); value.~Value(); }
     };
 
     //
@@ -71,21 +383,61 @@ public:
 	{
     //protected:
         HashEntry * entry;
+        // Occupancy bitmap of the table and its bounds, if known (set by
+        // begin()); otherwise increment checks slot by slot.
+        const uint64_t * occupancy;
+        HashEntry * base, * last;
+        // For the entry of the old table being migrated (incremental
+        // growth): the new table, that increment continues with once the
+        // end of the old one is passed, so it reaches end() anyway.
+        HashEntry * next;
     //public:
 		typedef HashEntry mypair;
 
-        myiterator( HashEntry * e ) :
-                    entry(e) {}
+        myiterator( HashEntry * e, HashEntry * nxt=nullptr_C11 ) :
+                    entry(e), occupancy(nullptr_C11), base(e), last(e),
+                    next(nxt) {}
+        myiterator( HashEntry * e, const uint64_t * occ,
+                    HashEntry * b, HashEntry * l ) :
+                    entry(e), occupancy(occ), base(b), last(l),
+                    next(nullptr_C11) {}
 
         myiterator & operator++() {
             (*this)++;
             return *this;
         }
         myiterator operator++(int) {
+            if( occupancy ) {
+                _next_occupied( entry - base + 1 );
+                return *this;
+            }
             //for( ++entry; entry->is_vacant(); ){ entry += 1; }
             do { ++entry; } while( (!entry->is_valid()) && (entry->hashValue != 0x3) );
+            if( next && !entry->is_valid() ) {
+                // end of the old table, go on with the new one
+                entry = next;
+                next = nullptr_C11;
+                if( !entry->is_valid() ) {
+                    (*this)++;
+                }
+            }
             return *this;
         }
+        /// Moves to the first valid entry starting from slot i (or to the
+        /// end marker), skipping the vacant words of the bitmap at once.
+        void _next_occupied( size_t i ) {
+            const size_t n = last - base;
+            size_t w = i >> 6;
+            uint64_t bits = i < n ? occupancy[w] & (~uint64_t(0) << (i & 63)) : 0;
+            while( !bits ) {
+                if( (++w << 6) >= n ) {
+                    entry = last;
+                    return;
+                }
+                bits = occupancy[w];
+            }
+            entry = base + (w << 6) + myhash_ctz64( bits );
+        }
         HashEntry * operator->() { return entry; }
         HashEntry & operator*() { return *entry; }
 
@@ -130,9 +482,13 @@ public:
     };
     # endif
 public:
-	myhash();
+	myhash( float maxLoadFactor=0.7, Size growthFactor=2 );
 	~myhash();
 
+    // Sharded wrapper uses stateless _lookup() and hashes the key only once.
+    template<typename, typename, typename, typename, typename, typename>
+    friend class myhash_concurrent;
+
 	VALUE & operator[](const KEY & k) { return at(k); }
 	const VALUE & operator[](const KEY & k) const { return at(k); }
 
@@ -148,87 +504,540 @@ public:
     // }}} Required specification ---------------------------------------------
     //
 private:
-    static HashFunction _hash_f;
     HashEntry * _table;
+    uint64_t * _occupancy;  // bit per slot of _table, set for valid entries
     mutable Size _latestSearchDepth;
-    Size _tableSize,
+    Size _tableSize,  // always a power of two
          _fillmentThreshold,
-         _nOccupiedEntries
+         _shrinkThreshold,
+         _nOccupiedEntries,  // in both tables, while migrating
+         _nTombstones  // in _table only
+         ;
+    float _maxLoadFactor,
+          _minLoadFactor;
+    uint8_t _growthShift;  // log2 of growth factor
+    // Incremental growth: old table being migrated (if any), its size and
+    // number of its slots migrated so far.
+    HashEntry * _oldTable;
+    Size _oldTableSize,
+         _nMigrated
          ;
+    // Incremental growth: storage for the next table and number of its
+    // entries constructed so far.
+    HashEntry * _nextTable;
+    Size _nPrepared;
+    # ifdef MYHASH_COLLECT_STATS
+    mutable myhash_stats _stats;
+    # endif
 protected:
+    static const Size _minTableSize = 8;
+    static const Size _batchSize = 16;
+    static HashValue _mix( HashValue h ) {
+        # ifndef MYHASH_MODULO_INDEXING
+        return myhash_fmix32(h);
+        # else
+        return h;
+        # endif
+    }
+    /// Returns (mixed) hash of the key, truncated to 30 bits that fit into
+    /// HashEntry::hashValue, so stored hash can be compared exactly.
+    template<typename LookupT>
+    static HashValue _hash( const LookupT & k ) {
+        return _mix( Hash::hash(k) ) & (~HashValue(0) >> 2); }
+    /// Returns true if entry at place may hold the key of given hash (its
+    /// stored hash matches), saving key comparison for the most of others.
+    static bool _hash_matches( const HashEntry & e, HashValue hv ) {
+        # ifndef MYHASH_NO_STORED_HASH
+        return (e.hashValue >> 2) == hv;
+        # else
+        return true;
+        # endif
+    }
+    bool _hash_matches( Size place, HashValue hv ) const {
+        return _hash_matches( _table[place], hv ); }
+    /// Returns initial probe slot for (mixed) hash in table of given size.
+    static Size _home( HashValue hv, Size tableSize ) {
+        # ifndef MYHASH_MODULO_INDEXING
+        return hv & (tableSize - 1);
+        # else
+        return hv % tableSize;
+        # endif
+    }
+    Size _home( HashValue hv ) const { return _home( hv, _tableSize ); }
+    /// Returns distance of the occupied slot from its entry's home slot.
+    Size _distance( Size place ) const {
+        # ifndef MYHASH_MODULO_INDEXING
+        return (place - _home( _table[place].hashValue >> 2 )) & (_tableSize - 1);
+        # else
+        Size h = _home( _table[place].hashValue >> 2 );
+        return place >= h ? place - h : place + _tableSize - h;
+        # endif
+    }
+    /// Returns next probe slot (linear probing, wraps around).
+    static Size _next( Size place, Size tableSize ) {
+        # ifndef MYHASH_MODULO_INDEXING
+        return (place + 1) & (tableSize - 1);
+        # else
+        return (place + 1) % tableSize;
+        # endif
+    }
+    Size _next( Size place ) const { return _next( place, _tableSize ); }
+    void _update_threshold();
     /// Inserts new element and returns iterator to newly inserted element.
-    iterator _insert_element( const Key & k, const Value & v);
+    template<typename K, typename V>
+    iterator _insert_element( K && k, V && v );
+    /// Places new (absent) element of given hash, table must have room.
+    template<typename K, typename ... ArgsT>
+    Size _insert_hashed( HashValue hv, K && k, ArgsT && ... args );
+    /// Robin Hood insertion of entry with given hash.
+    template<typename K, typename ... ArgsT>
+    Size _insert_robin_hood( HashValue hv, K && k, ArgsT && ... args );
+    /// Robin Hood placement of new entry at the slot where its probe
+    /// stopped, displacing the following ones.
+    template<typename K, typename ... ArgsT>
+    void _place_robin_hood( Size place, HashValue hv, K && k, ArgsT && ... args );
+    /// Robin Hood erasure: shifts following displaced entries back.
+    void _erase_backward_shift( Size place );
+    /// Single-probe lookup with insertion on miss: hashes the key once and
+    /// remembers the slot where new entry goes (the first tombstone met, or
+    /// the one where the probe stopped), so it is not re-probed unless the
+    /// table grows. On insertion key is constructed from k (moved, if
+    /// rvalue), value -- from args. Returns iterator and insertion flag.
+    template<typename LookupT, typename ... ArgsT>
+    std::pair<iterator, bool> _find_or_insert( LookupT && k, ArgsT && ... args ) {
+        return _find_or_insert_hashed( _hash(k), std::forward<LookupT>(k),
+                                       std::forward<ArgsT>(args)... ); }
+    /// Same as above, for the key of known hash (see _hash()).
+    template<typename LookupT, typename ... ArgsT>
+    std::pair<iterator, bool> _find_or_insert_hashed( HashValue hv, LookupT && k,
+                                                      ArgsT && ... args );
+    static const Key & _make_key( const Key & k ) { return k; }
+    static Key && _make_key( Key && k ) { return std::move(k); }
+    static Key _make_key( const myhash_string_ref & r ) { return Key( r.data, r.size ); }
+    /// Moves entry from the old table to the current one, using its stored
+    /// hash (used on growth, the key is not re-hashed).
+    void _relocate( HashEntry & e );
+    /// Occupancy bitmap maintenance: sets/clears the bit of the slot.
+    void _mark( Size place ) {
+        # ifndef MYHASH_NO_OCCUPANCY_BITMAP
+        _occupancy[place >> 6] |= uint64_t(1) << (place & 63);
+        # endif
+    }
+    void _unmark( Size place ) {
+        # ifndef MYHASH_NO_OCCUPANCY_BITMAP
+        _occupancy[place >> 6] &= ~(uint64_t(1) << (place & 63));
+        # endif
+    }
+    /// Number of 64-bit words in occupancy bitmap.
+    Size _occupancy_words() const { return (_tableSize + 63) >> 6; }
+    /// Allocates raw storage for n entries, constructing them vacant.
+    static HashEntry * _allocate( Size n );
+    /// Destroys n entries and frees storage.
+    static void _deallocate( HashEntry * t, Size n );
+    /// Migrates up to n next slots of the old table (incremental growth),
+    /// freeing it once all are migrated.
+    void _migrate( Size n );
+    void _complete_migration() { if( _oldTable ) _migrate( _oldTableSize ); }
+    /// Iterator to the found entry, that may belong to the old table.
+    iterator _iterator_at( const HashEntry * e ) const {
+        HashEntry * me = const_cast<HashEntry *>(e);
+        if( Growth::incremental && _oldTable
+         && e >= _oldTable && e < _oldTable + _oldTableSize ) {
+            return iterator( me, _table );
+        }
+        return iterator( me );
+    }
+    /// Constructs up to n next entries of the next table storage
+    /// (incremental growth), allocating it on first call.
+    void _prepare( Size n );
+    /// Incremental growth: migrates next slots of the old table, if any, or
+    /// prepares the next table once the threshold is near.
+    void _growth_step();
+    /// Looks up the old table (incremental growth), returns matching valid
+    /// entry or null.
+    template<typename LookupT>
+    const HashEntry * _find_in_old( const LookupT & k, HashValue hv,
+                                    Size & depth ) const;
+    /// Looks up both tables for the key of given hash, counting probes in
+    /// depth. Does not modify the table, so concurrent calls are safe.
+    template<typename LookupT>
+    const HashEntry * _lookup( const LookupT & k, HashValue hv, Size & depth ) const;
+    /// Looks up for the key or for the equivalent one (heterogeneous lookup).
+    template<typename LookupT>
+    const_iterator _find( const LookupT & k ) const;
     /// Frees hash table, if was allocated.
     void _free();
     /// For open addressing: deletes hash table and re-inserts all the stuff.
     void _grow();
+    /// Re-builds the table of given size at once, dropping tombstones.
+    void _rebuild( Size newSize );
+    /// Called when insertion meets the threshold: re-builds the table of
+    /// the same size if at least a quarter of the counted slots are
+    /// tombstones (so at least that many operations pass till the next
+    /// re-build), grows it otherwise. Small thresholds (low max load
+    /// factor) round the quarter to zero, so at least one tombstone is
+    /// required -- re-building the table without them frees nothing.
+    void _make_room() {
+        if( _nTombstones > 0
+         && _nTombstones >= std::max<Size>( 1, _fillmentThreshold/4 ) ) {
+            _rebuild( _tableSize );
+        } else {
+            _grow();
+        }
+    }
+    /// Growth threshold for the table of given size.
+    Size _threshold_of( Size tableSize ) const;
+    /// The smallest table size, that holds n entries without growth.
+    Size _size_for( Size n ) const;
 public:
-    Value & at( const KEY & k );
+    Value & at( const KEY & k ) { return _find_or_insert( k ).first->second; }
     const Value & at( const KEY & k ) const;
-    const_iterator find( const KEY & k ) const;
+
+    // Upsert API: key is hashed once and probed once (see _find_or_insert()).
+    /// Inserts element with key k and value constructed from args if k is
+    /// absent (args are not used otherwise). Returns iterator to the element
+    /// with key k and true if it was inserted.
+    template<typename ... ArgsT>
+    std::pair<iterator, bool> try_emplace( const Key & k, ArgsT && ... args ) {
+        return _find_or_insert( k, std::forward<ArgsT>(args)... ); }
+    /// Same as above, key is moved in on insertion.
+    template<typename ... ArgsT>
+    std::pair<iterator, bool> try_emplace( Key && k, ArgsT && ... args ) {
+        return _find_or_insert( std::move(k), std::forward<ArgsT>(args)... ); }
+    /// Constructs key from k and inserts it with value constructed from
+    /// args, unless the key is present.
+    template<typename K, typename ... ArgsT>
+    std::pair<iterator, bool> emplace( K && k, ArgsT && ... args ) {
+        return _find_or_insert( Key( std::forward<K>(k) ),
+                                std::forward<ArgsT>(args)... ); }
+    /// Inserts (k, v) if k is absent.
+    std::pair<iterator, bool> insert( const Key & k, const Value & v ) {
+        return _find_or_insert( k, v ); }
+    std::pair<iterator, bool> insert( Key && k, Value && v ) {
+        return _find_or_insert( std::move(k), std::move(v) ); }
+    /// Returns iterator to the element with key k, inserting default value
+    /// if k is absent.
+    iterator find_or_insert( const Key & k ) { return _find_or_insert( k ).first; }
+    iterator find_or_insert( const myhash_string_ref & r ) {
+        return _find_or_insert( r ).first; }
+    /// Adds delta to the value of key k (inserting default value, if
+    /// absent). Returns reference to the updated value.
+    Value & increment( const Key & k, const Value & delta=Value(1) ) {
+        return _find_or_insert( k ).first->second += delta; }
+    Value & increment( const myhash_string_ref & r, const Value & delta=Value(1) ) {
+        return _find_or_insert( r ).first->second += delta; }
+    /// Same as operator[](const KEY &), key is moved in on insertion.
+    Value & operator[]( Key && k ) { return _find_or_insert( std::move(k) ).first->second; }
+
+    const_iterator find( const KEY & k ) const { return _find(k); }
+
+    // Batched operations: keys are processed by groups of _batchSize; all
+    // the keys of the group are hashed and their home slots prefetched first,
+    // then the keys of the slots that match the stored hash are prefetched,
+    // and only then the lookups are resolved, so cache misses of different
+    // keys overlap instead of stalling one after another.
+    /// Looks up n keys, writing iterators (end() for absent keys) to out.
+    template<typename LookupT>
+    void find_batch( const LookupT * keys, size_t n, const_iterator * out ) const;
+    /// Inserts n (keys[i], values[i]) pairs, for the keys that are absent.
+    /// Returns number of inserted entries.
+    size_t insert_batch( const Key * keys, const Value * values, size_t n );
+
+    /// Calls f(const Key &, Value &) for every entry, in memory order (the
+    /// occupancy bitmap is scanned, so the vacant parts of the table are
+    /// skipped without touching them). f must not modify the table.
+    template<typename FuncT> void for_each( FuncT f );
+    template<typename FuncT> void for_each( FuncT f ) const;
+
+    // Heterogeneous lookup of string keys by character sequence, so that
+    // lookups do not construct temporary key; the key is constructed only
+    // when at()/operator[] inserts. With C++17 std::string_view converts to
+    // myhash_string_ref implicitly. C string overloads exist for string-like
+    // keys only (see myhash_if_c_string).
+    iterator find( const myhash_string_ref & r ) { return _find(r); }
+    const_iterator find( const myhash_string_ref & r ) const { return _find(r); }
+    template<typename CharT> typename myhash_if_c_string<Key, CharT, iterator>::type
+    find( const CharT * s ) { return _find( myhash_string_ref(s) ); }
+    template<typename CharT> typename myhash_if_c_string<Key, CharT, const_iterator>::type
+    find( const CharT * s ) const { return _find( myhash_string_ref(s) ); }
+    template<typename CharT> typename myhash_if_c_string<Key, CharT, iterator>::type
+    find( const CharT * s, size_t l ) { return _find( myhash_string_ref(s, l) ); }
+    template<typename CharT> typename myhash_if_c_string<Key, CharT, const_iterator>::type
+    find( const CharT * s, size_t l ) const { return _find( myhash_string_ref(s, l) ); }
+    Value & at( const myhash_string_ref & r ) { return _find_or_insert( r ).first->second; }
+    const Value & at( const myhash_string_ref & r ) const;
+    Value & operator[]( const myhash_string_ref & r ) { return at(r); }
+    const Value & operator[]( const myhash_string_ref & r ) const { return at(r); }
+    template<typename CharT> typename myhash_if_c_string<Key, CharT, Value &>::type
+    operator[]( const CharT * s ) { return at( myhash_string_ref(s) ); }
+    template<typename CharT> typename myhash_if_c_string<Key, CharT, const Value &>::type
+    operator[]( const CharT * s ) const { return at( myhash_string_ref(s) ); }
     Size table_size() const { return _tableSize; }
+    /// True while incremental growth has the old table to migrate. Lookups
+    /// may then return iterator to the entry of the old table, that is
+    /// incremented through the rest of it and then through the new table.
+    bool migrating() const { return _oldTable; }
+    /// Bytes allocated for the table(s) (not counting key's own heap storage).
+    size_t allocated_bytes() const {
+        return sizeof(HashEntry)*(_tableSize + 1
+                                  + (_oldTable ? _oldTableSize + 1 : 0)
+                                  + (_nextTable ? (_tableSize << _growthShift) + 1 : 0))
+             # ifndef MYHASH_NO_OCCUPANCY_BITMAP
+             + sizeof(uint64_t)*_occupancy_words()
+             # endif
+             ; }
+    /// Number of tombstones in the table.
+    Size tombstones() const { return _nTombstones; }
+    /// Writes JSON object with size, load, tombstones and allocated bytes,
+    /// followed by probe length histograms and growth statistics if they
+    /// are collected (MYHASH_COLLECT_STATS).
+    void dump_stats_json( FILE * f=stdout ) const;
+    /// Writes the flat snapshot of the table (see myhash_snapshot_header)
+    /// to be opened with myhash_mapped::open_mapped(). Key must be
+    /// std::string, value -- trivially copyable. The file is written aside
+    /// (path + ".tmp") and renamed, so the former one stays valid for its
+    /// readers. Throws std::runtime_error on I/O failure.
+    void save( const char * path ) const;
+    /// Builds immutable table of the current entries (copied) on minimal
+    /// perfect hash function: lookup is one slot access and one key
+    /// comparison, no vacant slots. Defined in frozenhash.hpp.
+    myhash_frozen<Key, Value, myhash_default_hash64<Key>, Equals> freeze() const;
+    # ifdef MYHASH_COLLECT_STATS
+    const myhash_stats & stats() const { return _stats; }
+    void reset_stats() { _stats.reset(); }
+    # endif
+    /// Number of probes made by the latest find()/insertion.
+    Size latest_search_depth() const { return _latestSearchDepth; }
 
-    void erase(const const_iterator & it);
+    float load_factor() const { return float(_nOccupiedEntries)/_tableSize; }
+    float max_load_factor() const { return _maxLoadFactor; }
+    /// Sets load factor (0, 1) that triggers growth. Does not shrink table.
+    void max_load_factor( float f );
+    Size growth_factor() const { return Size(1) << _growthShift; }
+    /// Sets table growth factor, must be a power of two >= 2.
+    void growth_factor( Size f );
 
-    // XXX: for benchmarking purposes
-    static void set_function( HashFunction f ) {
-        _hash_f = f;
-    }
-    static HashValue hash_byteseq( const uint8_t * b, Size l )
-                                                    { return _hash_f(b, l); }
+    // Compaction. Tombstones count toward max load factor; when insertion
+    // meets the threshold and at least a quarter of the counted slots are
+    // tombstones, the table is re-built at the same size instead of growth.
+    // All the re-builds below are stop-the-world: O(table size) time (even
+    // with incremental growth policy), both tables are allocated meanwhile,
+    // iterators are invalidated.
+    /// Re-builds the table with at least n slots (and not less than needed
+    /// to hold current entries), dropping tombstones.
+    void rehash( Size n );
+    /// Makes room for n entries to be held without growth. Does not shrink.
+    void reserve( Size n );
+    /// Shrinks the table to the smallest size that holds current entries.
+    void shrink_to_fit() { rehash( 0 ); }
+    float min_load_factor() const { return _minLoadFactor; }
+    /// Sets load factor below which erasure shrinks the table (down to the
+    /// load of about a half of max load factor). Must be less than a
+    /// quarter of max load factor, so shrinking and growth do not alternate;
+    /// 0 (default) disables shrinking.
+    void min_load_factor( float f );
+
+    void erase(const const_iterator & it);
 };  // class myhash
 
 // Implementation
 ////////////////
 
-template<typename KEY, typename VALUE>
-myhash<KEY, VALUE>::myhash() :
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::myhash( float maxLoadFactor,
+                                                               Size growthFactor ) :
                 _table( nullptr_C11 ),
+                _occupancy( nullptr_C11 ),
                 _latestSearchDepth( 0 ),
                 _tableSize( 1 ),
                 _fillmentThreshold( 0 ),
-                _nOccupiedEntries( 0 ) { _grow(); }
+                _shrinkThreshold( 0 ),
+                _nOccupiedEntries( 0 ),
+                _nTombstones( 0 ),
+                _maxLoadFactor( 0.7 ),
+                _minLoadFactor( 0 ),
+                _growthShift( 1 ),
+                _oldTable( nullptr_C11 ),
+                _oldTableSize( 0 ),
+                _nMigrated( 0 ),
+                _nextTable( nullptr_C11 ),
+                _nPrepared( 0 ) {
+    max_load_factor( maxLoadFactor );
+    growth_factor( growthFactor );
+    _grow();
+}
 
-template<typename KEY, typename VALUE>
-myhash<KEY, VALUE>::~myhash() {
-    if( !! _nOccupiedEntries ) {
-        _free();
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::max_load_factor( float f ) {
+    if( !(f > 0 && f < 1) ) {
+        throw std::invalid_argument( "Max load factor must be in (0, 1)." );
     }
+    _maxLoadFactor = f;
+    _update_threshold();
 }
 
-template<typename KEY, typename VALUE> typename myhash<KEY, VALUE>::iterator
-myhash<KEY, VALUE>::begin() {
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::growth_factor( Size f ) {
+    if( f < 2 || (f & (f - 1)) ) {
+        throw std::invalid_argument( "Growth factor must be a power of two." );
+    }
+    for( _growthShift = 0; f >>= 1; ++_growthShift ) {}
+    if( _nextTable ) {
+        // prepared for the former growth factor
+        _deallocate( _nextTable, _nPrepared );
+        _nextTable = nullptr_C11;
+    }
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_update_threshold() {
+    _fillmentThreshold = _threshold_of( _tableSize );
+    _shrinkThreshold = (Size) (_minLoadFactor*_tableSize);
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+typename myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::Size
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_threshold_of( Size tableSize ) const {
+    Size t = (Size) (_maxLoadFactor*tableSize);
+    // at least one vacant slot must remain to terminate probing
+    if( t >= tableSize ) {
+        t = tableSize - 1;
+    }
+    return t ? t : 1;
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+typename myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::Size
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_size_for( Size n ) const {
+    Size size = _minTableSize;
+    while( _threshold_of( size ) < n ) {
+        if( size > (std::numeric_limits<Size>::max() >> 2) ) {
+            throw std::length_error( "Hash table size limit exceeded." );
+        }
+        size <<= 1;
+    }
+    return size;
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::min_load_factor( float f ) {
+    if( !(f >= 0 && 4*f < _maxLoadFactor) ) {
+        throw std::invalid_argument( "Min load factor must be in [0, max load"
+                                     " factor/4)." );
+    }
+    _minLoadFactor = f;
+    _update_threshold();
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::rehash( Size n ) {
+    Size size = _size_for( _nOccupiedEntries );
+    while( size < n ) {
+        if( size > (std::numeric_limits<Size>::max() >> 2) ) {
+            throw std::length_error( "Hash table size limit exceeded." );
+        }
+        size <<= 1;
+    }
+    _rebuild( size );
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::reserve( Size n ) {
+    const Size size = _size_for( n );
+    if( size > _tableSize ) {
+        _rebuild( size );
+    }
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::~myhash() {
+    _free();
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+typename myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::iterator
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::begin() {
+    _complete_migration();
+    # ifndef MYHASH_NO_OCCUPANCY_BITMAP
+    iterator it( _table, _occupancy, _table, _table + _tableSize );
+    it._next_occupied( 0 );
+    # else
     iterator it(_table);
     if( !it.entry->is_valid() ) { ++it; }
+    # endif
     return it;
 }
 
-template<typename KEY, typename VALUE> const typename myhash<KEY, VALUE>::iterator
-myhash<KEY, VALUE>::begin() const {
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+const typename myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::iterator
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::begin() const {
+    // migration does not change the content, so it is legit for const
+    // iteration as well
+    const_cast<Self *>(this)->_complete_migration();
+    # ifndef MYHASH_NO_OCCUPANCY_BITMAP
+    const_iterator it( _table, _occupancy, _table, _table + _tableSize );
+    it._next_occupied( 0 );
+    # else
     const_iterator it(_table);
     if( !it.entry->is_valid() ) { ++it; }
+    # endif
     return it;
 }
 
-template<typename KEY, typename VALUE> typename myhash<KEY, VALUE>::iterator
-myhash<KEY, VALUE>::find(const KEY & k) {
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+typename myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::iterator
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::find(const KEY & k) {
     const Self * this_ = this;
-    return iterator( const_cast<HashEntry *>(this_->find(k).entry) );
+    return this_->find(k);
 }
 
-template<typename KEY, typename VALUE> typename myhash<KEY, VALUE>::iterator
-myhash<KEY, VALUE>::_insert_element( const Key & k, const Value & v) {
-    if( _nOccupiedEntries >= _fillmentThreshold ) {
-        _grow();
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+template<typename K, typename V>
+typename myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::iterator
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_insert_element( K && k, V && v ) {
+    if( _nOccupiedEntries + _nTombstones >= _fillmentThreshold ) {
+        _make_room();
     }
-    HashValue hv = myhash_hash_spec<Key>(k);
-    Size place = hv%table_size();
-    // linear probing strategy:
+    const HashValue hv = _hash(k);
+    return iterator( _table + _insert_hashed( hv, std::forward<K>(k),
+                                                  std::forward<V>(v) ) );
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+template<typename K, typename ... ArgsT>
+typename myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::Size
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_insert_hashed( HashValue hv,
+                                                                       K && k,
+                                                                       ArgsT && ... args ) {
+    if( Probing::robinHood ) {
+        Size place = _insert_robin_hood( hv, std::forward<K>(k),
+                                         std::forward<ArgsT>(args)... );
+        ++_nOccupiedEntries;
+        return place;
+    }
+    Size place = _home(hv);
+    // linear probing strategy, the key is absent, so the first tombstone
+    // may be taken as well:
     _latestSearchDepth = 0;
-    while( !_table[place].is_vacant() ) {
+    while( _table[place].is_occupied() ) {
         assert( _latestSearchDepth < table_size() );
         ++_latestSearchDepth;
-        place = (place+1)%table_size();
+        place = _next(place);
         # ifndef NDEBUG
         if( _latestSearchDepth > table_size() ) {
             throw std::runtime_error( "Hash table seems busy, bot growth "
@@ -236,105 +1045,636 @@ myhash<KEY, VALUE>::_insert_element( const Key & k, const Value & v) {
         }
         # endif
     }
-    _table[place].set( k, v, hv );
-    printout( "> inserted %s->%d at %d w hash=%d\n", k.c_str(), v, place, hv );  // XXX
+    if( _table[place].is_released() ) {
+        --_nTombstones;
+    }
+    _table[place].set( hv, std::forward<K>(k), std::forward<ArgsT>(args)... );
+    _mark( place );
+    printout( "> inserted %s at %d w hash=%d\n", _table[place].first.c_str(), place, hv );  // XXX
     ++_nOccupiedEntries;
-    return iterator( _table + place );
+    return place;
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+template<typename K, typename ... ArgsT>
+typename myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::Size
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_insert_robin_hood( HashValue hv,
+                                                                           K && k,
+                                                                           ArgsT && ... args ) {
+    Size place = _home(hv),
+         dist = 0;
+    // Skip the entries that are as far (or farther) from home as we are.
+    while( !_table[place].is_vacant() && _distance(place) >= dist ) {
+        place = _next(place);
+        ++dist;
+    }
+    _latestSearchDepth = dist;
+    _place_robin_hood( place, hv, std::forward<K>(k), std::forward<ArgsT>(args)... );
+    return place;
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+template<typename K, typename ... ArgsT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_place_robin_hood( Size place,
+                                                                          HashValue hv,
+                                                                          K && k,
+                                                                          ArgsT && ... args ) {
+    if( _table[place].is_vacant() ) {
+        _table[place].set( hv, std::forward<K>(k), std::forward<ArgsT>(args)... );
+        _mark( place );
+        return;
+    }
+    // Take the place of the richer entry and carry it further on, swapping
+    // with every next entry closer to its home than the carried one.
+    HashEntry carried;
+    carried.set( hv, std::forward<K>(k), std::forward<ArgsT>(args)... );
+    Size dist = _distance(place);  // of the entry to be carried
+    _table[place].swap( carried );
+    for(;;) {
+        place = _next(place);
+        ++dist;
+        if( _table[place].is_vacant() ) {
+            _table[place].relocate_from( carried );
+            _mark( place );
+            break;
+        }
+        Size d = _distance(place);
+        if( d < dist ) {
+            _table[place].swap( carried );
+            dist = d;
+        }
+    }
 }
 
-template<typename KEY, typename VALUE> void
-myhash<KEY, VALUE>::_free() {
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+template<typename LookupT, typename ... ArgsT>
+std::pair<typename myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::iterator, bool>
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_find_or_insert_hashed( HashValue hv,
+                                                                               LookupT && k,
+                                                                               ArgsT && ... args ) {
+    if( Growth::incremental ) {
+        _growth_step();
+    }
+    Size place = _home(hv),
+         reuse = _tableSize;  // first tombstone met, if any
+    for( _latestSearchDepth = 0; _latestSearchDepth < _tableSize;
+         place = _next(place), ++_latestSearchDepth ) {
+        const HashEntry & e = _table[place];
+        if( e.is_vacant() ) {
+            break;
+        }
+        if( Probing::robinHood && _distance(place) < _latestSearchDepth ) {
+            break;  // key would have displaced this entry, it goes here
+        }
+        if( e.is_released() ) {
+            if( _tableSize == reuse ) {
+                reuse = place;
+            }
+            continue;
+        }
+        if( _hash_matches( place, hv ) && Equals::equals( e.first, k ) ) {
+            # ifdef MYHASH_COLLECT_STATS
+            _stats.count_probe( true, _latestSearchDepth );
+            # endif
+            return std::make_pair( iterator( _table + place ), false );
+        }
+    }
+    if( Growth::incremental && _oldTable ) {
+        const HashEntry * e = _find_in_old( k, hv, _latestSearchDepth );
+        if( e ) {
+            # ifdef MYHASH_COLLECT_STATS
+            _stats.count_probe( true, _latestSearchDepth );
+            # endif
+            return std::make_pair( _iterator_at( e ), false );
+        }
+    }
+    # ifdef MYHASH_COLLECT_STATS
+    _stats.count_probe( false, _latestSearchDepth );
+    # endif
+    if( _nOccupiedEntries + _nTombstones >= _fillmentThreshold ) {
+        // remembered slot is lost on growth, but the hash is not
+        _make_room();
+        return std::make_pair( iterator( _table + _insert_hashed( hv,
+                                    _make_key( std::forward<LookupT>(k) ),
+                                    std::forward<ArgsT>(args)... ) ),
+                               true );
+    }
+    if( Probing::robinHood ) {
+        _place_robin_hood( place, hv, _make_key( std::forward<LookupT>(k) ),
+                           std::forward<ArgsT>(args)... );
+    } else {
+        if( _tableSize != reuse ) {
+            place = reuse;
+            --_nTombstones;
+        }
+        assert( !_table[place].is_occupied() );
+        _table[place].set( hv, _make_key( std::forward<LookupT>(k) ),
+                           std::forward<ArgsT>(args)... );
+        _mark( place );
+    }
+    ++_nOccupiedEntries;
+    return std::make_pair( iterator( _table + place ), true );
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_relocate( HashEntry & e ) {
+    const HashValue hv = e.hashValue >> 2;
+    ++_nOccupiedEntries;
+    if( Probing::robinHood ) {
+        _insert_robin_hood( hv, std::move(e.key), std::move(e.value) );
+        e.vacate();
+        return;
+    }
+    Size place = _home(hv);
+    // no equal keys in the new table (but there may be tombstones, if it
+    // is being migrated to)
+    while( _table[place].is_occupied() ) {
+        place = _next(place);
+    }
+    if( _table[place].is_released() ) {
+        --_nTombstones;
+    }
+    _table[place].relocate_from( e );
+    _mark( place );
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+typename myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::HashEntry *
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_allocate( Size n ) {
+    HashEntry * t = static_cast<HashEntry *>( ::operator new( sizeof(HashEntry)*n ) );
+    for( Size i = 0; i < n; ++i ) {
+        new (t + i) HashEntry();  // sets references and hash only
+    }
+    return t;
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_deallocate( HashEntry * t,
+                                                                    Size n ) {
+    for( Size i = 0; i < n; ++i ) {
+        t[i].~HashEntry();
+    }
+    ::operator delete( t );
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_migrate( Size n ) {
+    const Size depth = _latestSearchDepth;
+    const Size end = _oldTableSize - _nMigrated > n ? _nMigrated + n
+                                                    : _oldTableSize;
+    for( ; _nMigrated < end; ++_nMigrated ) {
+        HashEntry & e = _oldTable[_nMigrated];
+        if( !e.is_valid() ) {
+            continue;
+        }
+        --_nOccupiedEntries;  // _relocate() counts it again
+        _relocate( e );
+        e.hashValue = 0x2;  // tombstone, keeps old probe sequences
+    }
+    _latestSearchDepth = depth;
+    if( _oldTableSize == _nMigrated ) {
+        // only tombstones and vacant slots left, nothing to destroy
+        ::operator delete( _oldTable );
+        _oldTable = nullptr_C11;
+        _oldTableSize = _nMigrated = 0;
+    }
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_prepare( Size n ) {
+    const Size size = (_tableSize << _growthShift) + 1;
+    if( !_nextTable ) {
+        _nextTable = static_cast<HashEntry *>( ::operator new( sizeof(HashEntry)*size ) );
+        _nPrepared = 0;
+    }
+    const Size end = size - _nPrepared > n ? _nPrepared + n : size;
+    for( ; _nPrepared < end; ++_nPrepared ) {
+        new (_nextTable + _nPrepared) HashEntry();
+    }
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_growth_step() {
+    # ifdef MYHASH_COLLECT_STATS
+    myhash_stats::GrowthTimer timer( _stats );
+    # endif
+    if( _oldTable ) {
+        _migrate( Growth::migrationStep );
+        return;
+    }
+    if( _tableSize > (std::numeric_limits<Size>::max() >> (_growthShift + 1)) ) {
+        return;  // _grow() will throw
+    }
+    // number of insertions needed to construct the next table
+    const Size lead = ((_tableSize << _growthShift) + 1)/Growth::migrationStep + 1;
+    if( _nOccupiedEntries + _nTombstones + lead >= _fillmentThreshold ) {
+        _prepare( Growth::migrationStep );
+    }
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+template<typename LookupT>
+const typename myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::HashEntry *
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_find_in_old( const LookupT & k,
+                                                                     HashValue hv,
+                                                                     Size & depth ) const {
+    // Plain linear scan up to vacant slot: migrated slots are tombstones
+    // here, so Robin Hood early termination does not apply.
+    Size place = _home( hv, _oldTableSize );
+    for( Size n = 0; n < _oldTableSize && !_oldTable[place].is_vacant();
+         ++n, place = _next( place, _oldTableSize ) ) {
+        ++depth;
+        const HashEntry & e = _oldTable[place];
+        if( e.is_valid() && _hash_matches( e, hv ) && Equals::equals( e.first, k ) ) {
+            return &e;
+        }
+    }
+    return nullptr_C11;
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::dump_stats_json( FILE * f ) const {
+    fprintf( f, "{\"size\": %u, \"table_size\": %u, \"load_factor\": %.4f,"
+                " \"max_load_factor\": %.4f, \"tombstones\": %u,"
+                " \"allocated_bytes\": %zu, \"migrating\": %s",
+             (unsigned) _nOccupiedEntries, (unsigned) _tableSize, load_factor(),
+             _maxLoadFactor, (unsigned) tombstones(), allocated_bytes(),
+             _oldTable ? "true" : "false" );
+    # ifdef MYHASH_COLLECT_STATS
+    fprintf( f, ", \"grow_count\": %llu, \"grow_seconds\": %.6f",
+             (unsigned long long) _stats.nGrowths, _stats.growthNs*1e-9 );
+    const uint64_t * histograms[2] = { _stats.hits, _stats.misses };
+    const char * names[2] = { "hit_probes", "miss_probes" };
+    for( int h = 0; h < 2; ++h ) {
+        fprintf( f, ", \"%s\": [", names[h] );
+        for( unsigned i = 0; i < myhash_stats::nBins; ++i ) {
+            fprintf( f, i ? ", %llu" : "%llu", (unsigned long long) histograms[h][i] );
+        }
+        fputc( ']', f );
+    }
+    # endif
+    fputs( "}\n", f );
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::save( const char * path ) const {
+    typedef myhash_snapshot_slot<Value> Slot;
+    static_assert( std::is_trivially_copyable<Value>::value,
+                   "Snapshot value must be trivially copyable." );
+    myhash_snapshot_header h;
+    memset( &h, 0, sizeof(h) );
+    memcpy( h.magic, myhash_snapshot_magic, sizeof(h.magic) );
+    h.slotSize = sizeof(Slot);
+    h.valueSize = sizeof(Value);
+    h.tableSize = _size_for( _nOccupiedEntries );
+    h.nEntries = _nOccupiedEntries;
+    h.hashCheck = Hash::hash( Key("myhash") );
+    // slots are zeroed, i.e. vacant
+    std::vector<Slot> slots( h.tableSize );
+    std::string blob;
+    const Size mask = h.tableSize - 1;
+    for_each( [&]( const Key & k, const Value & v ) {
+            const uint32_t hv = myhash_snapshot_hash( Hash::hash(k) );
+            Size place = hv & mask;
+            while( slots[place].hashValue ) {
+                place = (place + 1) & mask;
+            }
+            Slot & s = slots[place];
+            s.hashValue = (hv << 1) | 0x1;
+            s.keyLength = k.size();
+            s.keyOffset = blob.size();
+            memcpy( &s.value, &v, sizeof(Value) );
+            blob.append( k );
+        } );
+    h.slotsOffset = (sizeof(h) + 63) & ~size_t(63);  // cache line aligned
+    h.blobOffset = h.slotsOffset + sizeof(Slot)*slots.size();
+    h.blobSize = blob.size();
+
+    const std::string tmpPath = std::string(path) + ".tmp";
+    FILE * f = fopen( tmpPath.c_str(), "wb" );
+    if( !f ) {
+        throw std::runtime_error( "Unable to open \"" + tmpPath + "\" for writing." );
+    }
+    const char padding[64] = {};
+    const size_t nPadding = h.slotsOffset - sizeof(h);
+    bool ok = fwrite( &h, sizeof(h), 1, f ) == 1
+           && fwrite( padding, 1, nPadding, f ) == nPadding
+           && fwrite( slots.data(), sizeof(Slot), slots.size(), f ) == slots.size()
+           && fwrite( blob.data(), 1, blob.size(), f ) == blob.size();
+    ok = !fclose( f ) && ok;
+    if( !ok || rename( tmpPath.c_str(), path ) ) {
+        remove( tmpPath.c_str() );
+        throw std::runtime_error( "Unable to write snapshot to \""
+                                  + std::string(path) + "\"." );
+    }
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_free() {
+    if( _table ) {
+        _deallocate( _table, _tableSize + 1 );
+        _table = nullptr_C11;
+    }
+    delete [] _occupancy;
+    _occupancy = nullptr_C11;
+    if( _oldTable ) {
+        _deallocate( _oldTable, _oldTableSize + 1 );
+        _oldTable = nullptr_C11;
+    }
+    if( _nextTable ) {
+        _deallocate( _nextTable, _nPrepared );
+        _nextTable = nullptr_C11;
+    }
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_grow() {
+    # ifdef MYHASH_COLLECT_STATS
+    myhash_stats::GrowthTimer timer( _stats );
     if( _table ) {
-        delete [] _table;
+        ++_stats.nGrowths;  // not the initial allocation
+    }
+    # endif
+    if( Growth::incremental ) {
+        _complete_migration();  // previous one, if any
+    }
+    if( _tableSize > (std::numeric_limits<Size>::max() >> (_growthShift + 1)) ) {
+        throw std::length_error( "Hash table size limit exceeded." );
+    }
+    Size newSize = _tableSize << _growthShift;
+    if( newSize < _minTableSize ) {
+        newSize = _minTableSize;
     }
+    if( !(Growth::incremental && _table) ) {
+        _rebuild( newSize );
+        return;
+    }
+    // entries will be moved by the following operations
+    _prepare( std::numeric_limits<Size>::max() );  // the rest, if any
+    _oldTable = _table;
+    _oldTableSize = _tableSize;
+    _nMigrated = 0;
+    _tableSize = newSize;
+    _update_threshold();
+    _table = _nextTable;
+    _nextTable = nullptr_C11;
+    _nPrepared = 0;
+    _table[_tableSize].hashValue = 0x3;  // end marker
+    _nTombstones = 0;
+    # ifndef MYHASH_NO_OCCUPANCY_BITMAP
+    delete [] _occupancy;  // entries of the old table are not tracked
+    _occupancy = new uint64_t [_occupancy_words()]();
+    # endif
+    _latestSearchDepth = 0;
 }
 
-template<typename KEY, typename VALUE> void
-myhash<KEY, VALUE>::_grow() {
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_rebuild( Size newSize ) {
+    if( Growth::incremental ) {
+        _complete_migration();
+        if( _nextTable && newSize != (_tableSize << _growthShift) ) {
+            _deallocate( _nextTable, _nPrepared );
+            _nextTable = nullptr_C11;
+        }
+    }
     HashEntry * oldTable = _table,
               * oldTableEnd = _table + _tableSize;
+    const Size oldTableSize = _tableSize;
+    if( _nextTable ) {
+        _prepare( std::numeric_limits<Size>::max() );  // the rest, if any
+    }
+    _tableSize = newSize;
+    _update_threshold();
+    if( _nextTable ) {
+        _table = _nextTable;
+        _nextTable = nullptr_C11;
+        _nPrepared = 0;
+    } else {
+        _table = _allocate( _tableSize + 1 );
+    }
+    _table[_tableSize].hashValue = 0x3;  // end marker
+    _nTombstones = 0;
+    # ifndef MYHASH_NO_OCCUPANCY_BITMAP
+    delete [] _occupancy;
+    _occupancy = new uint64_t [_occupancy_words()]();
+    # endif
+    _latestSearchDepth = 0;
+    if( !oldTable ) {
+        return;
+    }
     _nOccupiedEntries = 0;
-    _tableSize <<= 2;
-    _table = new HashEntry [_tableSize + 1];
-    if( oldTable ) {
-        for( const HashEntry * c = oldTable; oldTableEnd != c; ++c ) {
-            if( !c->is_valid() ) {
-                continue;
-            }
-            _insert_element( c->first, c->second );
+    for( HashEntry * c = oldTable; oldTableEnd != c; ++c ) {
+        if( !c->is_valid() ) {
+            continue;
         }
-        delete [] oldTable;
+        # ifndef MYHASH_NO_STORED_HASH
+        _relocate( *c );
+        # else
+        _insert_element( std::move(c->key), std::move(c->value) );
+        # endif
     }
+    _deallocate( oldTable, oldTableSize + 1 );
     _latestSearchDepth = 0;
-    _fillmentThreshold = (Size) 0.7*_tableSize;
-    _table[_tableSize].hashValue = 0x3;  // end marker
-    printout( "> grown to %d, end=%p, %p\n",
+    printout( "> re-built to %d, end=%p, %p\n",
                 _tableSize, _table + _tableSize,
                 iterator(_table + _tableSize).entry );  // XXX
 }
 
-template<typename KEY, typename VALUE> typename myhash<KEY, VALUE>::Value &
-myhash<KEY, VALUE>::at( const KEY & k ) {
-    printout( "> mutable at():\n" );  // XXX
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+const typename myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::Value &
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::at( const KEY & k ) const {
+    printout( "> immutable at():\n" );  // XXX
     const_iterator it = find(k);
     if( end() == it ) {
-        printout( "< mutable at() added new element.\n" );  // XXX
-        return _insert_element( k, Value() )->second;
+        throw std::out_of_range( "Element not found." );
     }
-    // The const validity was guaranteed by methods before, so the
-    // const_cast<>() here seemd legit.
-    printout( "< mutable at() returning existing element.\n" );  // XXX
-    return iterator( const_cast<HashEntry *>( it.entry ) )->second;
+    printout( "< immutable at().\n" );  // XXX
+    return it.entry->second;
 }
 
-template<typename KEY, typename VALUE> const typename myhash<KEY, VALUE>::Value &
-myhash<KEY, VALUE>::at( const KEY & k ) const {
-    printout( "> immutable at():\n" );  // XXX
-    const_iterator it = find(k);
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+const typename myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::Value &
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::at( const myhash_string_ref & r ) const {
+    const_iterator it = _find(r);
     if( end() == it ) {
         throw std::out_of_range( "Element not found." );
     }
-    printout( "< immutable at().\n" );  // XXX
-    return it;
+    return it.entry->second;
 }
 
-template<typename KEY, typename VALUE> typename myhash<KEY, VALUE>::const_iterator
-myhash<KEY, VALUE>::find( const KEY & k ) const {
-    HashValue hv = myhash_hash_spec<Key>(k);
-    Size place = hv%table_size();
-    _latestSearchDepth = 0;
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+template<typename LookupT>
+const typename myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::HashEntry *
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_lookup( const LookupT & k,
+                                                                HashValue hv,
+                                                                Size & depth ) const {
+    Size place = _home(hv);
+    depth = 0;
     printout( "> initial lookup state: hv=%d, place=%d, lsd=%d\n",
-            hv, place, _latestSearchDepth);
-    while( _latestSearchDepth < table_size()
+            hv, place, depth);
+    while( depth < table_size()
         && !_table[place].is_vacant()
         /*&& hv%table_size() == ((_table[place].hashValue) >> 2)%table_size()*/ ) {
-        if( myhash_equals<Key>( _table[place].first, k ) ) {
-            if( !_table[place].is_released() ) {
-                printout( "> have found %s at %d w val %d\n",
-                        k.c_str(),
-                        place,
-                        (_table + place)->second );  // XXX
-                return const_iterator( _table + place );
-            }
-            printout( "> omitting colliding %s at %d w val %d since it was erased\n",
-                    k.c_str(),
+        if( Probing::robinHood && _distance(place) < depth ) {
+            // key would have displaced this entry, so it is not here
+            break;
+        }
+        // tombstones hold no key
+        if( !_table[place].is_released()
+         && _hash_matches( place, hv ) && Equals::equals( _table[place].first, k ) ) {
+            printout( "> have found %s at %d w val %d\n",
+                    _table[place].first.c_str(),
                     place,
                     (_table + place)->second );  // XXX
+            return _table + place;
         }
-        printout( "* %s != %s\n", _table[place].first.c_str(), k.c_str() );
-        place=(place+1)%table_size();
-        ++_latestSearchDepth;
+        printout( "* mismatch at %d\n", place );
+        place = _next(place);
+        ++depth;
     }
     printout( "< final lookup state: hv=%d, place=%d, lsd=%d "
-              " (latest hv=%d) (entry %s NOT FOUND)\n",
-            hv, place, _latestSearchDepth, ((_table[place].hashValue) >> 2),
-            k.c_str() );
-    return end();
+              " (latest hv=%d) (entry NOT FOUND)\n",
+            hv, place, depth, ((_table[place].hashValue) >> 2) );
+    if( Growth::incremental && _oldTable ) {
+        return _find_in_old( k, hv, depth );
+    }
+    return nullptr_C11;
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+template<typename FuncT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::for_each( FuncT f ) {
+    _complete_migration();
+    # ifndef MYHASH_NO_OCCUPANCY_BITMAP
+    const Size nWords = _occupancy_words();
+    for( Size w = 0; w < nWords; ++w ) {
+        for( uint64_t bits = _occupancy[w]; bits; bits &= bits - 1 ) {
+            HashEntry & e = _table[(w << 6) + myhash_ctz64( bits )];
+            f( e.first, e.second );
+        }
+    }
+    # else
+    for( HashEntry * e = _table; e != _table + _tableSize; ++e ) {
+        if( e->is_valid() ) {
+            f( e->first, e->second );
+        }
+    }
+    # endif
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+template<typename FuncT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::for_each( FuncT f ) const {
+    const_cast<Self *>(this)->for_each( [&f]( const Key & k, Value & v ) {
+                f( k, const_cast<const Value &>(v) ); } );
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+template<typename LookupT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::find_batch( const LookupT * keys,
+                                                                   size_t n,
+                                                                   const_iterator * out ) const {
+    HashValue hvs[_batchSize];
+    for( size_t b = 0; b < n; b += _batchSize ) {
+        const Size m = n - b < _batchSize ? Size(n - b) : _batchSize;
+        const LookupT * k = keys + b;
+        for( Size i = 0; i < m && b + _batchSize + i < n; ++i ) {
+            myhash_prefetch_key( k[_batchSize + i] );  // for the next group
+        }
+        for( Size i = 0; i < m; ++i ) {
+            hvs[i] = _hash( k[i] );
+            MYHASH_PREFETCH( _table + _home( hvs[i] ) );
+        }
+        for( Size i = 0; i < m; ++i ) {
+            const HashEntry & e = _table[_home( hvs[i] )];
+            if( e.is_valid() && _hash_matches( e, hvs[i] ) ) {
+                myhash_prefetch_key( e.first );
+            }
+        }
+        for( Size i = 0; i < m; ++i ) {
+            const HashEntry * e = _lookup( k[i], hvs[i], _latestSearchDepth );
+            # ifdef MYHASH_COLLECT_STATS
+            _stats.count_probe( e, _latestSearchDepth );
+            # endif
+            out[b + i] = e ? _iterator_at( e ) : end();
+        }
+    }
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> size_t
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::insert_batch( const Key * keys,
+                                                                     const Value * values,
+                                                                     size_t n ) {
+    HashValue hvs[_batchSize];
+    size_t nInserted = 0;
+    for( size_t b = 0; b < n; b += _batchSize ) {
+        const Size m = n - b < _batchSize ? Size(n - b) : _batchSize;
+        const Key * k = keys + b;
+        for( Size i = 0; i < m && b + _batchSize + i < n; ++i ) {
+            myhash_prefetch_key( k[_batchSize + i] );
+        }
+        for( Size i = 0; i < m; ++i ) {
+            hvs[i] = _hash( k[i] );
+            MYHASH_PREFETCH( _table + _home( hvs[i] ) );
+        }
+        // (prefetched slots are lost, if the table grows within the group)
+        for( Size i = 0; i < m; ++i ) {
+            nInserted += _find_or_insert_hashed( hvs[i], k[i], values[b + i] ).second;
+        }
+    }
+    return nInserted;
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT>
+template<typename LookupT>
+typename myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::const_iterator
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_find( const LookupT & k ) const {
+    const HashEntry * e = _lookup( k, _hash(k), _latestSearchDepth );
+    # ifdef MYHASH_COLLECT_STATS
+    _stats.count_probe( e, _latestSearchDepth );
+    # endif
+    return e ? _iterator_at( e ) : end();
 }
 
-template<typename KEY, typename VALUE> void
-myhash<KEY, VALUE>::erase(const const_iterator & it) {
-    if( it.entry >= _table + table_size() || it.entry < _table ) {
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::erase(const const_iterator & it) {
+    if( Growth::incremental && _oldTable
+     && it.entry >= _oldTable && it.entry < _oldTable + _oldTableSize ) {
+        // not migrated yet; tombstone keeps the old probe sequences intact
+        if( !it.entry->is_valid() ) {
+            throw std::out_of_range( "Invalid iterator provided." );
+        }
+        --_nOccupiedEntries;
+        const_cast<HashEntry *>(it.entry)->release();
+        _growth_step();
+        return;
+    }
+    if( it.entry >= _table + table_size() || it.entry < _table
+     || !it.entry->is_valid() ) {
         throw std::out_of_range( "Invalid iterator provided." );
     }
     --_nOccupiedEntries;
@@ -342,7 +1682,35 @@ myhash<KEY, VALUE>::erase(const const_iterator & it) {
                 it.entry->first.c_str(),
                 it.entry->second,
                 it.entry );  // XXX
-    const_cast<HashEntry *>(it.entry)->release();
+    if( Probing::robinHood ) {
+        _erase_backward_shift( it.entry - _table );
+    } else {
+        const_cast<HashEntry *>(it.entry)->release();
+        _unmark( it.entry - _table );
+        ++_nTombstones;
+    }
+    if( Growth::incremental && _oldTable ) {
+        _growth_step();
+    } else if( _nOccupiedEntries < _shrinkThreshold ) {
+        const Size size = _size_for( 2*_nOccupiedEntries );
+        if( size < _tableSize ) {
+            _rebuild( size );
+        }
+    }
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT,
+         typename ProbingT, typename GrowthT> void
+myhash<KEY, VALUE, HashT, EqualsT, ProbingT, GrowthT>::_erase_backward_shift( Size place ) {
+    // Shift back the run of displaced entries following the erased one,
+    // until vacant slot or entry sitting at its home slot.
+    for( Size nxt = _next(place);
+         _table[nxt].is_occupied() && _distance(nxt) > 0;
+         place = nxt, nxt = _next(nxt) ) {
+        _table[place].swap( _table[nxt] );
+    }
+    _table[place].vacate();
+    _unmark( place );
 }
 
 //__ This part has to be put into an implementation file //////////////////////
@@ -356,6 +1724,90 @@ uint32_t adler32( const uint8_t * b, uint32_t l ) {
      return (s2 << 16) | s1;
 }
 
+// wyhash-class (https://github.com/wangyi-fudan/wyhash, final version 4)
+// 64-bit hash: consumes input 8 (16, 48) bytes at a time and mixes with
+// 64x64->128 multiplication folded to 64 bits. Short keys (<=16 bytes) are
+// read with at most four overlapping loads without a loop.
+
+static inline void
+_wymum( uint64_t * a, uint64_t * b ) {
+    # ifdef __SIZEOF_INT128__
+    __uint128_t r = *a;
+    r *= *b;
+    *a = (uint64_t) r;
+    *b = (uint64_t) (r >> 64);
+    # else
+    uint64_t ha = *a >> 32, hb = *b >> 32,
+             la = (uint32_t) *a, lb = (uint32_t) *b,
+             rh = ha*hb, rm0 = ha*lb, rm1 = hb*la, rl = la*lb,
+             t = rl + (rm0 << 32), c = t < rl,
+             lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    # endif
+}
+
+static inline uint64_t
+_wymix( uint64_t a, uint64_t b ) { _wymum( &a, &b ); return a ^ b; }
+
+static inline uint64_t
+_wyr8( const uint8_t * p ) { uint64_t v; memcpy( &v, p, 8 ); return v; }
+
+static inline uint64_t
+_wyr4( const uint8_t * p ) { uint32_t v; memcpy( &v, p, 4 ); return v; }
+
+static inline uint64_t
+_wyr3( const uint8_t * p, size_t k ) {
+    return (((uint64_t) p[0]) << 16) | (((uint64_t) p[k >> 1]) << 8) | p[k - 1];
+}
+
+uint64_t wyhash64( const uint8_t * p, uint64_t l, uint64_t seed ) {
+    static const uint64_t s[4] = { 0xa0761d6478bd642full, 0xe7037ed1a0b428dbull,
+                                   0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull };
+    seed ^= _wymix( seed ^ s[0], s[1] );
+    uint64_t a, b;
+    if( l <= 16 ) {
+        if( l >= 4 ) {
+            a = (_wyr4(p) << 32) | _wyr4( p + ((l >> 3) << 2) );
+            b = (_wyr4(p + l - 4) << 32) | _wyr4( p + l - 4 - ((l >> 3) << 2) );
+        } else if( l > 0 ) {
+            a = _wyr3( p, l );
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        uint64_t i = l;
+        if( i > 48 ) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = _wymix( _wyr8(p) ^ s[1], _wyr8(p + 8) ^ seed );
+                see1 = _wymix( _wyr8(p + 16) ^ s[2], _wyr8(p + 24) ^ see1 );
+                see2 = _wymix( _wyr8(p + 32) ^ s[3], _wyr8(p + 40) ^ see2 );
+                p += 48;
+                i -= 48;
+            } while( i > 48 );
+            seed ^= see1 ^ see2;
+        }
+        for( ; i > 16; i -= 16, p += 16 ) {
+            seed = _wymix( _wyr8(p) ^ s[1], _wyr8(p + 8) ^ seed );
+        }
+        a = _wyr8( p + i - 16 );
+        b = _wyr8( p + i - 8 );
+    }
+    a ^= s[1];
+    b ^= seed;
+    _wymum( &a, &b );
+    return _wymix( a ^ s[0] ^ l, b ^ s[1] );
+}
+
+/// 32-bit fold of wyhash64() to fit the HashFunction signature.
+uint32_t wyhash( const uint8_t * b, uint32_t l ) {
+    uint64_t h = wyhash64( b, l, 0 );
+    return (uint32_t) (h ^ (h >> 32));
+}
+
 uint32_t djb2( const uint8_t * b, uint32_t l ) {
     const uint8_t * bEnd = b + l;
     uint32_t v = 5381;
@@ -375,20 +1827,43 @@ uint32_t sdbm( const uint8_t * b, uint32_t l ) {
 }
 
 
-template<typename KEY, typename VALUE>
-typename myhash<KEY, VALUE>::HashFunction
-myhash<KEY, VALUE>::_hash_f = adler32;
+template<typename T>
+typename myhash_runtime_hash<T>::HashFunction
+myhash_runtime_hash<T>::function = wyhash;
 
-template<> uint32_t
+template<> inline uint32_t
 myhash_hash_spec<std::string>( const std::string & v ) {
-    return myhash<std::string, int>::hash_byteseq(
-        (const uint8_t *) v.c_str(), v.size() );  // TODO
+    return wyhash( (const uint8_t *) v.data(), v.size() );
 }
 
-template<> bool
+template<> inline bool
 myhash_equals<std::string>( const std::string & l, const std::string & r ) {
     return l == r;
 }
+
+template<> inline uint32_t
+myhash_hash_spec<myhash_string_ref>( const myhash_string_ref & r ) {
+    return wyhash( (const uint8_t *) r.data, r.size );
+}
+
+template<> inline bool
+myhash_equals<std::string>( const std::string & l, const myhash_string_ref & r ) {
+    return l.size() == r.size && !memcmp( l.data(), r.data, r.size );
+}
+// Integer keys are hashed by value (myhash_integer_hash()), not as byte
+// sequences.
+# define MYHASH_INTEGER_KEY( T )                                        \
+template<> inline uint32_t                                              \
+myhash_hash_spec<T>( const T & v ) { return myhash_integer_hash( v ); } \
+template<> inline bool                                                  \
+myhash_equals<T>( const T & l, const T & r ) { return l == r; }
+MYHASH_INTEGER_KEY( int )
+MYHASH_INTEGER_KEY( unsigned int )
+MYHASH_INTEGER_KEY( long )
+MYHASH_INTEGER_KEY( unsigned long )
+MYHASH_INTEGER_KEY( long long )
+MYHASH_INTEGER_KEY( unsigned long long )
+# undef MYHASH_INTEGER_KEY
 //^^ This part has to be put into an implementation file //////////////////////
 
 # endif  // H_RDUS_MYHASH_H
@@ -0,0 +1,140 @@
+# include <string>
+# include <vector>
+# include <iostream>
+# include <random>
+# include <chrono>
+# include <algorithm>
+
+# include <cstdlib>
+# include <cstdio>
+
+# include "rdus.hpp"
+
+//
+// Mass erasure (rolling window): myhash<std::string, int> is filled with
+// nKeys keys, then 90% of them are erased. Table memory, lookup latency of
+// hits and misses and full iteration time are sampled after filling, after
+// erasure, and after shrink_to_fit() (its time is reported as well). The
+// last row is for the table with automatic shrinking on erasure
+// (min_load_factor(0.1)).
+//
+// Usage:
+//  $ shrink-bench [nKeys]
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static void
+random_tokens( std::vector<std::string> & dest, size_t n, size_t length,
+               std::mt19937 & rng ) {
+    dest.reserve( dest.size() + n );
+    for( size_t i = 0; i < n; ++i ) {
+        std::string tok( length, ' ' );
+        for( size_t j = 0; j < length; ++j ) {
+            tok[j] = 'a' + rng()%26;
+        }
+        dest.push_back( tok );
+    }
+}
+
+static double
+ns_per_op( Clock::time_point s, Clock::time_point e, size_t n ) {
+    return std::chrono::duration<double, std::nano>(e - s).count()/n;
+}
+
+template<typename TableT> bool
+sample( const char * stage, double opMs, TableT & t,
+        const std::vector<std::string> & live,
+        const std::vector<std::string> & missQueries ) {
+    size_t nFound = 0;
+    Clock::time_point s = Clock::now();
+    for( size_t i = 0; i < live.size(); ++i ) {
+        nFound += t.find( live[i] ) != t.end();
+    }
+    const double hit = ns_per_op( s, Clock::now(), live.size() );
+    s = Clock::now();
+    for( size_t i = 0; i < missQueries.size(); ++i ) {
+        nFound += t.find( missQueries[i] ) != t.end();
+    }
+    const double miss = ns_per_op( s, Clock::now(), missQueries.size() );
+    long sum = 0;
+    s = Clock::now();
+    t.for_each( [&sum]( const std::string &, int & v ) { sum += v; } );
+    const double iter = ns_per_op( s, Clock::now(), t.size() );
+    if( nFound != live.size() || (size_t) t.size() != live.size() ) {
+        std::cerr << "Integrity check failure: " << stage << ", " << nFound
+                  << " found, " << t.size() << " entries instead of "
+                  << live.size() << " (" << sum << ")." << std::endl;
+        return false;
+    }
+    printf( "%-16s%10u%10u%8.1f%10.2f%10.2f%10.2f%10.2f\n", stage, t.table_size(),
+            t.tombstones(), t.allocated_bytes()/1048576., hit, miss, iter, opMs );
+    return true;
+}
+
+template<typename TableT> bool
+bench_shrink( const char * name, const std::vector<std::string> & keys,
+              const std::vector<std::string> & missQueries ) {
+    printf( "# %s\n%-16s%10s%10s%8s%10s%10s%10s%10s\n", name, "stage", "slots",
+            "tombs", "MB", "hit,ns", "miss,ns", "iter,ns", "op,ms" );
+    std::vector<std::string> kept;
+    for( size_t i = 0; i < keys.size(); i += 10 ) {
+        kept.push_back( keys[i] );
+    }
+    for( int automatic = 0; automatic < 2; ++automatic ) {
+        TableT t;
+        if( automatic ) {
+            t.min_load_factor( 0.1 );
+        }
+        for( size_t i = 0; i < keys.size(); ++i ) {
+            t[keys[i]] = (int) i;
+        }
+        if( !automatic && !sample( "filled", 0, t, keys, missQueries ) ) {
+            return false;
+        }
+        Clock::time_point s = Clock::now();
+        for( size_t i = 0; i < keys.size(); ++i ) {
+            if( i % 10 ) {
+                t.erase( keys[i] );
+            }
+        }
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - s).count();
+        if( automatic ) {
+            if( !sample( "auto, erased", ms, t, kept, missQueries ) ) {
+                return false;
+            }
+            break;
+        }
+        if( !sample( "90% erased", ms, t, kept, missQueries ) ) {
+            return false;
+        }
+        s = Clock::now();
+        t.shrink_to_fit();
+        ms = std::chrono::duration<double, std::milli>(Clock::now() - s).count();
+        if( !sample( "shrink_to_fit()", ms, t, kept, missQueries ) ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int
+main( int argc, const char * argv[] ) {
+    const size_t nKeys = argc > 1 ? strtoul( argv[1], NULL, 0 ) : 2000000;
+    std::mt19937 rng(1337);
+    std::vector<std::string> keys, missQueries;
+    random_tokens( keys, nKeys, 15, rng );
+    // longer by one char, so never present
+    random_tokens( missQueries, nKeys/10, 16, rng );
+    std::shuffle( keys.begin(), keys.end(), rng );
+
+    typedef myhash<std::string, int> LinearHash;
+    typedef myhash< std::string, int
+                  , myhash_default_hash<std::string>
+                  , myhash_default_equals<std::string>
+                  , myhash_robin_hood_probing > RobinHoodHash;
+    if( !bench_shrink<LinearHash>( "linear probing", keys, missQueries )
+     || !bench_shrink<RobinHoodHash>( "Robin Hood", keys, missQueries ) ) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+# include <string>
+# include <vector>
+# include <iostream>
+# include <random>
+# include <chrono>
+# include <algorithm>
+
+# include <cstdlib>
+# include <cstdio>
+
+# include "swisshash.hpp"
+
+//
+// Lookup latency of SwissTable-style myhash_swiss (control bytes + SSE2
+// group probing) versus myhash with linear and Robin Hood probing, at the
+// load factors of 0.5, 0.75 and 0.875. All the tables are filled with
+// load*tableSize keys with max load factor of 0.9, so each ends up with the
+// same table size and requested load (nothing is grown after it exceeds
+// 0.45).
+//
+// Usage:
+//  $ swiss-bench [log2TableSize [keyLength]]
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static void
+random_tokens( std::vector<std::string> & dest, size_t n, size_t length,
+               std::mt19937 & rng ) {
+    dest.reserve( dest.size() + n );
+    for( size_t i = 0; i < n; ++i ) {
+        std::string tok( length, ' ' );
+        for( size_t j = 0; j < length; ++j ) {
+            tok[j] = 'a' + rng()%26;
+        }
+        dest.push_back( tok );
+    }
+}
+
+struct Timings {
+    double hit, miss, load;
+};
+
+template<typename TableT> bool
+bench_load( const std::vector<std::string> & keys,
+            const std::vector<std::string> & hitQueries,
+            const std::vector<std::string> & missQueries,
+            Timings & r ) {
+    TableT t( 0.9 );
+    for( size_t i = 0; i < keys.size(); ++i ) {
+        t[keys[i]] = (int) i;
+    }
+    r.load = t.load_factor();
+
+    size_t nHits = 0;
+    Clock::time_point s = Clock::now();
+    for( size_t i = 0; i < hitQueries.size(); ++i ) {
+        nHits += t.find( hitQueries[i] ) != t.end();
+    }
+    Clock::time_point e = Clock::now();
+    r.hit = std::chrono::duration<double, std::nano>(e - s).count()/hitQueries.size();
+
+    s = Clock::now();
+    for( size_t i = 0; i < missQueries.size(); ++i ) {
+        nHits += t.find( missQueries[i] ) != t.end();
+    }
+    e = Clock::now();
+    r.miss = std::chrono::duration<double, std::nano>(e - s).count()/missQueries.size();
+
+    if( nHits != hitQueries.size() ) {
+        std::cerr << "Integrity check failure: " << nHits << " hits instead of "
+                  << hitQueries.size() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int
+main( int argc, const char * argv[] ) {
+    const size_t log2Size = argc > 1 ? strtoul( argv[1], NULL, 0 ) : 20,
+                 keyLength = argc > 2 ? strtoul( argv[2], NULL, 0 ) : 15,
+                 tableSize = size_t(1) << log2Size;
+    const double loads[] = { 0.5, 0.75, 0.875 };
+
+    typedef myhash<std::string, int> LinearHash;
+    typedef myhash< std::string, int
+                  , myhash_default_hash<std::string>
+                  , myhash_default_equals<std::string>
+                  , myhash_robin_hood_probing > RobinHoodHash;
+    typedef myhash_swiss<std::string, int> SwissHash;
+
+    printf( "# table size %zu, keys of %zu bytes, ns/find\n"
+            "%6s%12s%12s%12s%12s%12s%12s\n", tableSize, keyLength, "load",
+            "linear,hit", "miss", "RH,hit", "miss", "swiss,hit", "miss" );
+    for( size_t l = 0; l < sizeof(loads)/sizeof(*loads); ++l ) {
+        std::mt19937 rng(1337);
+        std::vector<std::string> keys, hitQueries, missQueries;
+        random_tokens( keys, size_t(loads[l]*tableSize), keyLength, rng );
+        hitQueries = keys;
+        std::shuffle( hitQueries.begin(), hitQueries.end(), rng );
+        // longer by one char, so never present
+        random_tokens( missQueries, keys.size(), keyLength + 1, rng );
+
+        Timings lin, rh, sw;
+        if( !bench_load<LinearHash>( keys, hitQueries, missQueries, lin )
+         || !bench_load<RobinHoodHash>( keys, hitQueries, missQueries, rh )
+         || !bench_load<SwissHash>( keys, hitQueries, missQueries, sw ) ) {
+            return EXIT_FAILURE;
+        }
+        printf( "%6.3f%12.2f%12.2f%12.2f%12.2f%12.2f%12.2f\n", sw.load,
+                lin.hit, lin.miss, rh.hit, rh.miss, sw.hit, sw.miss );
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,476 @@
+# ifndef H_RDUS_MYHASH_SWISS_H
+# define H_RDUS_MYHASH_SWISS_H
+
+# include "rdus.hpp"
+
+# include <utility>
+
+# ifdef __SSE2__
+# include <emmintrin.h>
+# endif
+
+//
+// SwissTable-style open addressing hash. The table keeps a separate array of
+// one-byte control words, one per slot:
+//  - ctrlEmpty (0x80) for never occupied slot,
+//  - ctrlDeleted (0xfe) for the erased one (tombstone),
+//  - 0..0x7f for occupied slot -- 7 low bits of the (mixed) hash.
+// Lookup starts at the slot given by the rest of the hash bits, loads the 16
+// control bytes of the group starting there and compares them with the key's
+// 7-bit fragment at once (one SSE2 compare + movemask), so keys are compared
+// only for the slots whose fragment matches (~1/128 false positive rate).
+// Probing stops at the group that has an empty slot; groups are visited in
+// triangular order (offsets 16, 48, 96, ...), which covers all the slots of
+// power-of-two table.
+//
+// First 16 control bytes are cloned past the table end, so group starting at
+// any slot is loaded with one unaligned read without wrap-around handling.
+//
+// Tombstones count toward max load factor; when the threshold is reached
+// the table is re-built in place if more than a half of the counted slots are
+// tombstones, and is grown otherwise.
+//
+// Storage is struct-of-arrays: control bytes, keys and values live in three
+// separate arrays, so probing touches only the control bytes and the keys of
+// fragment-matching slots, and no per-slot reference members are stored
+// (cf. myhash::HashEntry). Key and value arrays are raw storage: only the
+// occupied slots hold constructed objects, so growth constructs nothing for
+// vacant slots and Key needs no default constructor. Iterator dereferences
+// to a Reference proxy binding ->first/->second and ->key/->value to the
+// slot's key and value.
+//
+// Interface follows myhash (operator[], find(), erase(), iterator with
+// ->first/->second and ->key/->value).
+
+template<typename KEY, typename VALUE,
+         typename HashT=myhash_default_hash<KEY>,
+         typename EqualsT=myhash_default_equals<KEY> >
+class myhash_swiss {
+public:
+    typedef uint32_t Size;
+    typedef uint32_t HashValue;
+    typedef KEY Key;
+    typedef VALUE Value;
+    typedef HashT Hash;
+    typedef EqualsT Equals;
+    typedef myhash_swiss<Key, Value, Hash, Equals> Self;
+    typedef int8_t Ctrl;
+
+    static const Ctrl ctrlEmpty = -128;  // 0x80
+    static const Ctrl ctrlDeleted = -2;  // 0xfe
+    static const Size groupWidth = 16;
+
+    /// Proxy returned by iterator dereference, ref members for spec
+    /// compat.
+    struct Reference {
+        const Key & first;
+        Value & second;
+        const Key & key;
+        Value & value;
+
+        Reference( const Key & k, Value & v ) :
+                    first(k), second(v), key(k), value(v) {}
+        /// Makes iterator's operator->() chain to the members.
+        Reference * operator->() { return this; }
+    };
+
+    /// Group of 16 control bytes starting at given one. Match methods return
+    /// bitmask with i-th bit set for matching i-th slot of the group.
+    struct Group {
+        # ifdef __SSE2__
+        __m128i ctrl;
+
+        explicit Group( const Ctrl * p ) :
+                ctrl( _mm_loadu_si128( reinterpret_cast<const __m128i *>(p) ) ) {}
+        uint32_t match( Ctrl h2 ) const {
+            return _mm_movemask_epi8( _mm_cmpeq_epi8( ctrl, _mm_set1_epi8(h2) ) ); }
+        uint32_t match_empty() const { return match( ctrlEmpty ); }
+        /// Empty and deleted control bytes are the only ones with sign bit.
+        uint32_t match_empty_or_deleted() const {
+            return _mm_movemask_epi8( ctrl ); }
+        # else
+        const Ctrl * ctrl;
+
+        explicit Group( const Ctrl * p ) : ctrl(p) {}
+        uint32_t match( Ctrl h2 ) const {
+            uint32_t m = 0;
+            for( Size i = 0; i < groupWidth; ++i ) {
+                m |= uint32_t(ctrl[i] == h2) << i;
+            }
+            return m;
+        }
+        uint32_t match_empty() const { return match( ctrlEmpty ); }
+        uint32_t match_empty_or_deleted() const {
+            uint32_t m = 0;
+            for( Size i = 0; i < groupWidth; ++i ) {
+                m |= uint32_t(ctrl[i] < 0) << i;
+            }
+            return m;
+        }
+        # endif
+    };
+
+    struct iterator {
+        Key * key;
+        Value * value;
+        const Ctrl * ctrl,
+                   * ctrlEnd;
+
+        iterator( Key * k, Value * v, const Ctrl * c, const Ctrl * cEnd ) :
+                    key(k), value(v), ctrl(c), ctrlEnd(cEnd) {}
+
+        /// Moves to the next occupied slot (or to the end).
+        iterator & operator++() {
+            do { ++key; ++value; ++ctrl; } while( ctrl != ctrlEnd && *ctrl < 0 );
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator it(*this);
+            ++(*this);
+            return it;
+        }
+        Reference operator->() const { return Reference( *key, *value ); }
+        Reference operator*() const { return Reference( *key, *value ); }
+
+        friend bool operator!= (const iterator & l,
+                                const iterator & r) { return l.ctrl != r.ctrl; }
+        friend bool operator== (const iterator & l,
+                                const iterator & r) { return ! (l != r); }
+    };
+    typedef iterator const_iterator;
+private:
+    Ctrl * _ctrl;  // _capacity + groupWidth bytes
+    Key * _keys;
+    Value * _values;
+    Size _capacity,  // always a power of two, >= groupWidth
+         _fillmentThreshold,
+         _nOccupiedEntries,
+         _nDeleted
+         ;
+    float _maxLoadFactor;
+    uint8_t _growthShift;  // log2 of growth factor
+protected:
+    static HashValue _hash( const Key & k ) { return myhash_fmix32( Hash::hash(k) ); }
+    /// 7-bit fragment stored in control byte.
+    static Ctrl _h2( HashValue hv ) { return Ctrl(hv & 0x7f); }
+    /// Slot the probing starts from.
+    Size _h1( HashValue hv ) const { return (hv >> 7) & (_capacity - 1); }
+    static unsigned _lowest_bit( uint32_t m ) {
+        # ifdef __GNUC__
+        return __builtin_ctz(m);
+        # else
+        unsigned n = 0;
+        for( ; !(m & 0x1); m >>= 1 ) ++n;
+        return n;
+        # endif
+    }
+    /// Number of leading zero bits of 16-bit group mask.
+    static unsigned _leading_zeros16( uint32_t m ) {
+        unsigned n = 0;
+        for( uint32_t b = 0x8000; b && !(m & b); b >>= 1 ) ++n;
+        return n;
+    }
+    /// Sets control byte, keeping its clone past the table end in sync.
+    void _set_ctrl( Size place, Ctrl c ) {
+        _ctrl[place] = c;
+        if( place < groupWidth ) {
+            _ctrl[_capacity + place] = c;
+        }
+    }
+    iterator _iterator( Size place ) const {
+        return iterator( _keys + place, _values + place,
+                         _ctrl + place, _ctrl + _capacity ); }
+    /// Returns slot index of the key, or _capacity if not found. Sets
+    /// insertPlace to the first empty or deleted slot met on the probe
+    /// sequence, where the key goes if absent.
+    Size _find( const Key & k, HashValue hv, Size & insertPlace ) const;
+    Size _find( const Key & k, HashValue hv ) const {
+        Size insertPlace;
+        return _find( k, hv, insertPlace );
+    }
+    /// Returns the first empty or deleted slot on the key's probe sequence.
+    Size _find_insert_slot( HashValue hv ) const;
+    /// Inserts new element (must be absent) at the slot found by _find(),
+    /// probing again only if the table has to be re-built. Returns its slot
+    /// index.
+    Size _insert_element( Size place, HashValue hv, const Key & k, const Value & v );
+    /// Allocates uninitialized storage for n objects.
+    template<typename T> static T * _allocate( Size n ) {
+        return static_cast<T *>( ::operator new( sizeof(T)*n ) ); }
+    void _update_threshold();
+    /// Re-builds the table with given capacity (power of two), dropping
+    /// tombstones.
+    void _rehash( Size newCapacity );
+public:
+    myhash_swiss( float maxLoadFactor=0.875, Size growthFactor=2 );
+    ~myhash_swiss();
+
+    myhash_swiss( const Self & ) = delete;
+    Self & operator=( const Self & ) = delete;
+
+    Value & operator[]( const Key & k ) { return at(k); }
+    const Value & operator[]( const Key & k ) const { return at(k); }
+
+    Value & at( const Key & k );
+    const Value & at( const Key & k ) const;
+
+    iterator begin() const;
+    iterator end() const { return _iterator( _capacity ); }
+
+    iterator find( const Key & k ) const { return _iterator( _find( k, _hash(k) ) ); }
+
+    void erase( const Key & k ) { iterator it = find(k); if( it != end() ) erase(it); }
+    void erase( const const_iterator & it );
+
+    int size() const { return (int) _nOccupiedEntries; }
+    Size table_size() const { return _capacity; }
+    Size tombstones() const { return _nDeleted; }
+    /// Bytes allocated for the table (not counting key's own heap storage).
+    size_t allocated_bytes() const {
+        return size_t(_capacity)*(sizeof(Key) + sizeof(Value) + sizeof(Ctrl))
+             + groupWidth*sizeof(Ctrl); }
+
+    float load_factor() const { return float(_nOccupiedEntries)/_capacity; }
+    float max_load_factor() const { return _maxLoadFactor; }
+    /// Sets load factor (0, 1) that triggers growth. Does not shrink table.
+    void max_load_factor( float f );
+    Size growth_factor() const { return Size(1) << _growthShift; }
+    /// Sets table growth factor, must be a power of two >= 2.
+    void growth_factor( Size f );
+};  // class myhash_swiss
+
+// Implementation
+////////////////
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT>
+myhash_swiss<KEY, VALUE, HashT, EqualsT>::myhash_swiss( float maxLoadFactor,
+                                                        Size growthFactor ) :
+                _ctrl( nullptr_C11 ),
+                _keys( nullptr_C11 ),
+                _values( nullptr_C11 ),
+                _capacity( groupWidth ),
+                _fillmentThreshold( 0 ),
+                _nOccupiedEntries( 0 ),
+                _nDeleted( 0 ),
+                _maxLoadFactor( 0.875 ),
+                _growthShift( 1 ) {
+    max_load_factor( maxLoadFactor );
+    growth_factor( growthFactor );
+    _rehash( groupWidth );
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT>
+myhash_swiss<KEY, VALUE, HashT, EqualsT>::~myhash_swiss() {
+    for( Size i = 0; i < _capacity; ++i ) {
+        if( _ctrl[i] >= 0 ) {
+            _keys[i].~Key();
+            _values[i].~Value();
+        }
+    }
+    ::operator delete( _values );
+    ::operator delete( _keys );
+    delete [] _ctrl;
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT> void
+myhash_swiss<KEY, VALUE, HashT, EqualsT>::max_load_factor( float f ) {
+    if( !(f > 0 && f < 1) ) {
+        throw std::invalid_argument( "Max load factor must be in (0, 1)." );
+    }
+    _maxLoadFactor = f;
+    _update_threshold();
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT> void
+myhash_swiss<KEY, VALUE, HashT, EqualsT>::growth_factor( Size f ) {
+    if( f < 2 || (f & (f - 1)) ) {
+        throw std::invalid_argument( "Growth factor must be a power of two." );
+    }
+    for( _growthShift = 0; f >>= 1; ++_growthShift ) {}
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT> void
+myhash_swiss<KEY, VALUE, HashT, EqualsT>::_update_threshold() {
+    _fillmentThreshold = (Size) (_maxLoadFactor*_capacity);
+    // at least one empty slot must remain to terminate probing
+    if( _fillmentThreshold >= _capacity ) {
+        _fillmentThreshold = _capacity - 1;
+    }
+    if( !_fillmentThreshold ) {
+        _fillmentThreshold = 1;
+    }
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT>
+typename myhash_swiss<KEY, VALUE, HashT, EqualsT>::iterator
+myhash_swiss<KEY, VALUE, HashT, EqualsT>::begin() const {
+    iterator it = _iterator(0);
+    if( *it.ctrl < 0 ) { ++it; }
+    return it;
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT>
+typename myhash_swiss<KEY, VALUE, HashT, EqualsT>::Size
+myhash_swiss<KEY, VALUE, HashT, EqualsT>::_find( const Key & k,
+                                                 HashValue hv,
+                                                 Size & insertPlace ) const {
+    const Size mask = _capacity - 1;
+    const Ctrl h2 = _h2(hv);
+    Size pos = _h1(hv);
+    insertPlace = _capacity;
+    for( Size step = 0; step <= _capacity; ) {
+        Group g( _ctrl + pos );
+        for( uint32_t m = g.match(h2); m; m &= m - 1 ) {
+            Size place = (pos + _lowest_bit(m)) & mask;
+            if( Equals::equals( _keys[place], k ) ) {
+                return place;
+            }
+        }
+        if( _capacity == insertPlace ) {
+            if( uint32_t m = g.match_empty_or_deleted() ) {
+                insertPlace = (pos + _lowest_bit(m)) & mask;
+            }
+        }
+        if( g.match_empty() ) {
+            break;
+        }
+        step += groupWidth;
+        pos = (pos + step) & mask;
+    }
+    return _capacity;
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT>
+typename myhash_swiss<KEY, VALUE, HashT, EqualsT>::Size
+myhash_swiss<KEY, VALUE, HashT, EqualsT>::_find_insert_slot( HashValue hv ) const {
+    const Size mask = _capacity - 1;
+    Size pos = _h1(hv);
+    for( Size step = 0; ; ) {
+        uint32_t m = Group( _ctrl + pos ).match_empty_or_deleted();
+        if( m ) {
+            return (pos + _lowest_bit(m)) & mask;
+        }
+        step += groupWidth;
+        pos = (pos + step) & mask;
+        # ifndef NDEBUG
+        if( step > _capacity ) {
+            throw std::runtime_error( "Hash table seems busy, but growth "
+                "condition failed." );  // must never happen
+        }
+        # endif
+    }
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT>
+typename myhash_swiss<KEY, VALUE, HashT, EqualsT>::Size
+myhash_swiss<KEY, VALUE, HashT, EqualsT>::_insert_element( Size place,
+                                                           HashValue hv,
+                                                           const Key & k,
+                                                           const Value & v ) {
+    // re-used tombstone does not change the number of counted slots
+    if( (_capacity == place || ctrlDeleted != _ctrl[place])
+     && _nOccupiedEntries + _nDeleted >= _fillmentThreshold ) {
+        if( _nDeleted > _nOccupiedEntries ) {
+            _rehash( _capacity );  // just purge tombstones
+        } else {
+            if( _capacity > (std::numeric_limits<Size>::max() >> (_growthShift + 1)) ) {
+                throw std::length_error( "Hash table size limit exceeded." );
+            }
+            _rehash( _capacity << _growthShift );
+        }
+        place = _capacity;
+    }
+    if( _capacity == place ) {
+        place = _find_insert_slot( hv );
+    }
+    new (_keys + place) Key( k );
+    new (_values + place) Value( v );
+    if( ctrlDeleted == _ctrl[place] ) {
+        --_nDeleted;
+    }
+    _set_ctrl( place, _h2(hv) );
+    ++_nOccupiedEntries;
+    return place;
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT> void
+myhash_swiss<KEY, VALUE, HashT, EqualsT>::_rehash( Size newCapacity ) {
+    Ctrl * oldCtrl = _ctrl;
+    Key * oldKeys = _keys;
+    Value * oldValues = _values;
+    const Size oldCapacity = _capacity;
+
+    _capacity = newCapacity;
+    _update_threshold();
+    _ctrl = new Ctrl [_capacity + groupWidth];
+    memset( _ctrl, ctrlEmpty, _capacity + groupWidth );
+    _keys = _allocate<Key>( _capacity );
+    _values = _allocate<Value>( _capacity );
+    _nDeleted = 0;
+    if( oldCtrl ) {
+        for( Size i = 0; i < oldCapacity; ++i ) {
+            if( oldCtrl[i] < 0 ) {
+                continue;
+            }
+            HashValue hv = _hash( oldKeys[i] );
+            Size place = _find_insert_slot( hv );
+            _set_ctrl( place, _h2(hv) );
+            new (_keys + place) Key( std::move( oldKeys[i] ) );
+            new (_values + place) Value( std::move( oldValues[i] ) );
+            oldKeys[i].~Key();
+            oldValues[i].~Value();
+        }
+        ::operator delete( oldValues );
+        ::operator delete( oldKeys );
+        delete [] oldCtrl;
+    }
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT>
+typename myhash_swiss<KEY, VALUE, HashT, EqualsT>::Value &
+myhash_swiss<KEY, VALUE, HashT, EqualsT>::at( const Key & k ) {
+    const HashValue hv = _hash(k);
+    Size insertPlace,
+         place = _find( k, hv, insertPlace );
+    if( _capacity == place ) {
+        place = _insert_element( insertPlace, hv, k, Value() );
+    }
+    return _values[place];
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT>
+const typename myhash_swiss<KEY, VALUE, HashT, EqualsT>::Value &
+myhash_swiss<KEY, VALUE, HashT, EqualsT>::at( const Key & k ) const {
+    Size place = _find( k, _hash(k) );
+    if( _capacity == place ) {
+        throw std::out_of_range( "Element not found." );
+    }
+    return _values[place];
+}
+
+template<typename KEY, typename VALUE, typename HashT, typename EqualsT> void
+myhash_swiss<KEY, VALUE, HashT, EqualsT>::erase( const const_iterator & it ) {
+    if( it.ctrl >= _ctrl + _capacity || it.ctrl < _ctrl || *it.ctrl < 0 ) {
+        throw std::out_of_range( "Invalid iterator provided." );
+    }
+    const Size place = it.ctrl - _ctrl;
+    _keys[place].~Key();
+    _values[place].~Value();
+    --_nOccupiedEntries;
+    // If the slot has never been a part of full group on any probe sequence
+    // passing through it (i.e. there is an empty slot among the 16 ones
+    // before and after it) no lookup could have continued past it, so it may
+    // be marked as empty instead of tombstone.
+    const Size mask = _capacity - 1;
+    uint32_t emptyAfter = Group( _ctrl + place ).match_empty(),
+             emptyBefore = Group( _ctrl + ((place - groupWidth) & mask) ).match_empty();
+    if( emptyAfter && emptyBefore
+     && _lowest_bit(emptyAfter) + _leading_zeros16(emptyBefore) < groupWidth ) {
+        _set_ctrl( place, ctrlEmpty );
+    } else {
+        _set_ctrl( place, ctrlDeleted );
+        ++_nDeleted;
+    }
+}
+
+# endif  // H_RDUS_MYHASH_SWISS_H
@@ -12,8 +12,8 @@ using namespace std;
 
 #else
 
-//# include "rdus.hpp"
-# include "rdus.h"
+# include "rdus.hpp"
+//# include "rdus.h"
 
 # endif
 ///////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,133 @@
+# include <string>
+# include <vector>
+# include <iostream>
+# include <random>
+# include <chrono>
+# include <algorithm>
+
+# include <cstdlib>
+# include <cstdio>
+
+# include "rdus.hpp"
+
+//
+// Long keys workload: myhash<std::string, int> filled with URL-like keys of
+// 50-200 bytes sharing a few common prefixes (so false candidate keys tend
+// to match over a long prefix and std::string comparison is expensive).
+// Measures insertion (dominated by growth) and lookup of hits and misses.
+// To compare with the former behaviour (no stored hash check, re-hashing on
+// growth), build it twice:
+//  $ g++ -std=c++11 -O2 url-bench.cpp -o url-bench
+//  $ g++ -std=c++11 -O2 -DMYHASH_NO_STORED_HASH url-bench.cpp -o url-bench-nsh
+//
+// Usage:
+//  $ url-bench [nKeys [maxLoadFactor]]
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static const char * gPrefixes[] = {
+    "https://www.example.com/",
+    "https://cdn.static.example.net/assets/",
+    "http://mirror.example.org/pub/linux/distributions/",
+    "https://api.example.io/v2/resources/items/",
+};
+
+static std::string
+random_url( std::mt19937 & rng ) {
+    std::uniform_int_distribution<size_t> lenD( 50, 200 );
+    const size_t length = lenD(rng);
+    std::string url( gPrefixes[rng()%(sizeof(gPrefixes)/sizeof(*gPrefixes))] );
+    while( url.size() < length ) {
+        const size_t l = 3 + rng()%10;
+        for( size_t j = 0; j < l && url.size() < length; ++j ) {
+            url += char('a' + rng()%26);
+        }
+        if( url.size() < length ) url += '/';
+    }
+    return url;
+}
+
+static double
+ns_per_op( Clock::time_point s, Clock::time_point e, size_t n ) {
+    return std::chrono::duration<double, std::nano>(e - s).count()/n;
+}
+
+template<typename TableT> bool
+bench_urls( const char * name,
+            const std::vector<std::string> & keys,
+            const std::vector<std::string> & hitQueries,
+            const std::vector<std::string> & missQueries,
+            float maxLoad ) {
+    TableT t( maxLoad );
+    Clock::time_point s = Clock::now();
+    for( size_t i = 0; i < keys.size(); ++i ) {
+        t[keys[i]] = (int) i;
+    }
+    Clock::time_point e = Clock::now();
+    const double tIns = ns_per_op( s, e, keys.size() );
+
+    size_t nHits = 0;
+    s = Clock::now();
+    for( size_t i = 0; i < hitQueries.size(); ++i ) {
+        nHits += t.find( hitQueries[i] ) != t.end();
+    }
+    e = Clock::now();
+    const double tHit = ns_per_op( s, e, hitQueries.size() );
+
+    s = Clock::now();
+    for( size_t i = 0; i < missQueries.size(); ++i ) {
+        nHits += t.find( missQueries[i] ) != t.end();
+    }
+    e = Clock::now();
+    const double tMiss = ns_per_op( s, e, missQueries.size() );
+
+    if( nHits != hitQueries.size() ) {
+        std::cerr << "Integrity check failure: " << nHits
+                  << " hits instead of " << hitQueries.size() << std::endl;
+        return false;
+    }
+    printf( "%-26s%10.2f%10.2f%10.2f\n", name, tIns, tHit, tMiss );
+    return true;
+}
+
+int
+main( int argc, const char * argv[] ) {
+    const size_t nKeys = argc > 1 ? strtoul( argv[1], NULL, 0 ) : 1000000;
+    const float maxLoad = argc > 2 ? strtof( argv[2], NULL ) : 0.7;
+    std::mt19937 rng(1337);
+
+    std::vector<std::string> keys, hitQueries, missQueries;
+    keys.reserve( nKeys );
+    missQueries.reserve( nKeys );
+    size_t nBytes = 0;
+    for( size_t i = 0; i < nKeys; ++i ) {
+        keys.push_back( random_url( rng ) );
+        nBytes += keys.back().size();
+        // same URL with query string appended, so never present
+        missQueries.push_back( keys.back() + "?q=1" );
+    }
+    hitQueries = keys;
+    std::shuffle( hitQueries.begin(), hitQueries.end(), rng );
+    std::shuffle( missQueries.begin(), missQueries.end(), rng );
+
+    # ifdef MYHASH_NO_STORED_HASH
+    const char mode[] = "no stored hash";
+    # else
+    const char mode[] = "stored hash";
+    # endif
+    printf( "# %zu URLs, mean length %.1f, max load %.3f, %s, ns/op\n"
+            "%-26s%10s%10s%10s\n", nKeys, double(nBytes)/nKeys, maxLoad, mode,
+            "probing", "insert", "hit", "miss" );
+
+    typedef myhash<std::string, int> LinearHash;
+    typedef myhash< std::string, int
+                  , myhash_default_hash<std::string>
+                  , myhash_default_equals<std::string>
+                  , myhash_robin_hood_probing > RobinHoodHash;
+    if( !bench_urls<LinearHash>( "linear", keys, hitQueries, missQueries, maxLoad )
+     || !bench_urls<RobinHoodHash>( "Robin Hood", keys, hitQueries, missQueries,
+                                    maxLoad ) ) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,180 @@
+# include <string>
+# include <vector>
+# include <fstream>
+# include <sstream>
+# include <iostream>
+# include <random>
+# include <chrono>
+# include <algorithm>
+# include <unordered_map>
+
+# include <cstdlib>
+# include <cstdio>
+# include <cctype>
+
+# include "rdus.hpp"
+
+//
+// Word frequency counting with myhash<std::string, int> as the backend.
+// Words are tokenized into (ptr, len) views of the text buffer and counted
+// with:
+//  - ++h[std::string(word)] -- temporary key for every word;
+//  - find() by view, then try_emplace() on miss -- two hashes and two probe
+//    sequences for every new word (the former operator[] behaviour);
+//  - increment() by view -- single hash and single probe;
+//  - std::unordered_map<std::string, int> for reference.
+//
+// Usage:
+//  $ wordcount-bench [text-file-1 [text-file-2 ...]]
+// With no files given, generates the corpus of 10M words drawn from 1M words
+// vocabulary with Zipf's distribution.
+
+typedef std::chrono::high_resolution_clock Clock;
+typedef std::vector<myhash_string_ref> Tokens;
+
+static void
+read_text( const char * path, std::string & text ) {
+    std::ifstream f( path );
+    if( !f ) {
+        std::cerr << "Warning: unable to open \"" << path << "\"." << std::endl;
+        return;
+    }
+    std::stringstream ss;
+    ss << f.rdbuf();
+    text += ss.str();
+    text += ' ';
+}
+
+static void
+generate_text( std::string & text, size_t nWords, size_t nVocabulary ) {
+    std::mt19937 rng(1337);
+    std::vector<std::string> vocabulary;
+    std::vector<double> cdf;
+    double sum = 0;
+    for( size_t i = 0; i < nVocabulary; ++i ) {
+        std::string w( 3 + rng()%10, ' ' );
+        for( size_t j = 0; j < w.size(); ++j ) {
+            w[j] = 'a' + rng()%26;
+        }
+        vocabulary.push_back( w );
+        sum += 1./(i + 1);
+        cdf.push_back( sum );
+    }
+    std::uniform_real_distribution<double> u( 0, sum );
+    for( size_t i = 0; i < nWords; ++i ) {
+        size_t n = std::lower_bound( cdf.begin(), cdf.end(), u(rng) ) - cdf.begin();
+        text += vocabulary[std::min( n, nVocabulary - 1 )];
+        text += ' ';
+    }
+}
+
+static void
+tokenize( const std::string & text, Tokens & tokens ) {
+    const char * c = text.data(),
+               * end = text.data() + text.size();
+    while( c != end ) {
+        while( c != end && !isalpha( (unsigned char) *c ) ) ++c;
+        const char * b = c;
+        while( c != end && isalpha( (unsigned char) *c ) ) ++c;
+        if( c != b ) {
+            tokens.push_back( myhash_string_ref( b, c - b ) );
+        }
+    }
+}
+
+typedef myhash<std::string, int> LinearHash;
+typedef myhash< std::string, int
+              , myhash_default_hash<std::string>
+              , myhash_default_equals<std::string>
+              , myhash_robin_hood_probing > RobinHoodHash;
+
+template<typename TableT> void
+count_temporary( TableT & h, const Tokens & tokens ) {
+    for( size_t i = 0; i < tokens.size(); ++i ) {
+        ++h[std::string( tokens[i].data, tokens[i].size )];
+    }
+}
+
+template<typename TableT> void
+count_find_then_insert( TableT & h, const Tokens & tokens ) {
+    for( size_t i = 0; i < tokens.size(); ++i ) {
+        typename TableT::iterator it = h.find( tokens[i] );
+        if( it == h.end() ) {
+            h.try_emplace( std::string( tokens[i].data, tokens[i].size ), 1 );
+        } else {
+            ++it->second;
+        }
+    }
+}
+
+template<typename TableT> void
+count_increment( TableT & h, const Tokens & tokens ) {
+    for( size_t i = 0; i < tokens.size(); ++i ) {
+        h.increment( tokens[i] );
+    }
+}
+
+template<typename TableT> bool
+run( const char * name, void (*count)( TableT &, const Tokens & ),
+     const Tokens & tokens, size_t & nDistinct ) {
+    TableT h;
+    Clock::time_point s = Clock::now();
+    count( h, tokens );
+    Clock::time_point e = Clock::now();
+    size_t total = 0;
+    for( typename TableT::iterator it = h.begin(); it != h.end(); ++it ) {
+        total += it->second;
+    }
+    if( total != tokens.size() || (nDistinct && nDistinct != (size_t) h.size()) ) {
+        std::cerr << "Integrity check failure: " << name << " counted "
+                  << total << " words, " << h.size() << " distinct." << std::endl;
+        return false;
+    }
+    nDistinct = h.size();
+    const double ms = std::chrono::duration<double, std::milli>(e - s).count();
+    printf( "%-36s%10.2f%10.2f\n", name, ms, tokens.size()/ms/1e3 );
+    return true;
+}
+
+static void
+count_std( std::unordered_map<std::string, int> & m, const Tokens & tokens ) {
+    for( size_t i = 0; i < tokens.size(); ++i ) {
+        ++m[std::string( tokens[i].data, tokens[i].size )];
+    }
+}
+
+int
+main( int argc, const char * argv[] ) {
+    std::string text;
+    if( argc > 1 ) {
+        for( int i = 1; i < argc; ++i ) {
+            read_text( argv[i], text );
+        }
+    } else {
+        generate_text( text, 10000000, 1000000 );
+    }
+    Tokens tokens;
+    tokenize( text, tokens );
+    if( tokens.empty() ) {
+        std::cerr << "No words read." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    size_t nDistinct = 0;
+    printf( "# %zu words\n%-36s%10s%10s\n", tokens.size(),
+            "backend", "ms", "Mwords/s" );
+    if( !run<LinearHash>( "temporary std::string, operator[]",
+                          count_temporary<LinearHash>, tokens, nDistinct )
+     || !run<LinearHash>( "find() + try_emplace()",
+                          count_find_then_insert<LinearHash>, tokens, nDistinct )
+     || !run<LinearHash>( "increment()",
+                          count_increment<LinearHash>, tokens, nDistinct )
+     || !run<RobinHoodHash>( "increment(), Robin Hood",
+                             count_increment<RobinHoodHash>, tokens, nDistinct )
+     || !run< std::unordered_map<std::string, int> >( "std::unordered_map",
+                          count_std, tokens, nDistinct ) ) {
+        return EXIT_FAILURE;
+    }
+    printf( "# %zu distinct words\n", nDistinct );
+    return EXIT_SUCCESS;
+}